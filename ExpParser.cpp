@@ -1,112 +1,187 @@
 #include "ExpParser.hpp"
 #include <iostream>
-#include <sstream>
+#include <iterator>
 
 
 
 namespace ExpParser
 {
 
+double Importer::pop()
+{
+    const double value = _values.top();
+    _values.pop();
+    return value;
+}
+
 void Importer::add()
 {
     std::cout << '+' << ' ';
-    _expression.push(Operator::ADD);
+    const double right = pop();
+    _values.top() += right;
 }
 
 void Importer::sub()
 {
     std::cout << '-' << ' ';
-    _expression.push(Operator::SUB);
+    const double right = pop();
+    _values.top() -= right;
 }
 
 void Importer::mul()
 {
     std::cout << '*' << ' ';
-    _expression.push(Operator::MUL);
+    const double right = pop();
+    _values.top() *= right;
 }
 
 void Importer::div()
 {
     std::cout << '/' << ' ';
-    _expression.push(Operator::DIV);
+    const double right = pop();
+    _values.top() /= right;
 }
 
 void Importer::num(const int value)
 {
     std::cout << value << ' ';
-    _expression.push(static_cast<double>(value));
+    _values.push(static_cast<double>(value));
 }
 
-void Importer::solve()
+double Importer::result() const
 {
-    double temp;
-    size_t count;
-    while (!_expression.empty())
-    {
-        _cache.push_back(_expression.top());
-        _expression.pop();
-        count = _cache.size();
-        while (count >= 3 && _cache[count - 1].index() == 0 
-            && _cache[count - 2].index() == 0 && _cache[count - 3].index() == 1)
-        {
-            switch (std::get<Operator>(_cache[count - 3]))
-            {
-            case Operator::ADD:
-                temp = std::get<double>(_cache[count - 1]) + std::get<double>(_cache[count - 2]);
-                break;
-            case Operator::SUB:
-                temp = std::get<double>(_cache[count - 1]) - std::get<double>(_cache[count - 2]);
-                break;
-            case Operator::MUL:
-                temp = std::get<double>(_cache[count - 1]) * std::get<double>(_cache[count - 2]);
-                break;
-            case Operator::DIV:
-                temp = std::get<double>(_cache[count - 1]) / std::get<double>(_cache[count - 2]);
-                break;
-            }
-            _cache.pop_back();
-            _cache.pop_back();
-            _cache.back() = temp;
-            count = _cache.size();
-        }
-    }
-    _cache.clear();
-    std::cout << "= " << temp << std::endl;
+    return _values.empty() ? 0.0 : _values.top();
 }
 
-static Importer importer;
-
-static Action<void> add_a(&importer, &Importer::add);
-static Action<void> sub_a(&importer, &Importer::sub);
-static Action<void> mul_a(&importer, &Importer::mul);
-static Action<void> div_a(&importer, &Importer::div);
-static Action<int> num_a(&importer, &Importer::num);
+// the actions run on the Importer of the current parse, see Context
+static const Action<void> add_a = action<&Importer::add>();
+static const Action<void> sub_a = action<&Importer::sub>();
+static const Action<void> mul_a = action<&Importer::mul>();
+static const Action<void> div_a = action<&Importer::div>();
+static const Action<int> num_a = action<&Importer::num>();
 
 Parser<char> space = ch_p(' ');
 
-Parser<bool> Parsers::exper = std::ref(term) >>
-    *(*space >> ((ch_p('+') >> std::ref(term))[add_a] | (ch_p('-') >> std::ref(term))[sub_a]));
+// parentheses nest through C++ recursion, deeper input is refused rather than overflowing the
+// stack; a level takes about 2 KB of stack unoptimized and 0.6 KB at -O2
+static size_t nesting_limit = 200;
+
+Parser<bool> Parsers::factor = name_p("factor",
+    *space >> (expect_p("number", int_p()[num_a]) | pair_p(ch_p('('), depth_p(std::cref(nesting_limit), std::ref(exper)),  *space >> ch_p(')'))));
+
+Parser<bool> Parsers::exper = name_p("exper", expression_p(factor, {
+    {*space >> ch_p('+'), 1, Associativity::LEFT, add_a},
+    {*space >> ch_p('-'), 1, Associativity::LEFT, sub_a},
+    {*space >> ch_p('*'), 2, Associativity::LEFT, mul_a},
+    {*space >> ch_p('/'), 2, Associativity::LEFT, div_a}}));
 
-Parser<bool> Parsers::term = std::ref(factor) >>
-    *(*space >> ((ch_p('*') >> std::ref(factor))[mul_a] | (ch_p('/') >> std::ref(factor))[div_a]));
 
-Parser<bool> Parsers::factor = *space >> (int_p()[num_a] | pair_p(ch_p('('), std::ref(exper),  *space >> ch_p(')')));
+static std::string &last_error()
+{
+    static thread_local std::string error;
+    return error;
+}
 
+// parses an expression at the front of stream with the actions running on importer; a failure
+// is described from the furthest failure. With report_trailing, a parse that stops before
+// input other than white space still succeeds, and error() tells where and why it stopped.
+static bool run(std::string_view &stream, Importer &importer, const bool report_trailing)
+{
+    const std::string_view input(stream);
+    Failure failure;
+    const Context<Failure>::Scope failure_scope(failure);
+    const Context<Importer>::Scope scope(importer);
+    Nesting::current().exceeded = false;
+    if (Parsers::exper(stream) && !Nesting::current().exceeded)
+    {
+        last_error().clear();
+        const size_t trailing = stream.find_first_not_of(" \t\r\n");
+        if (report_trailing && trailing != std::string_view::npos)
+        {
+            if (!failure.failed() || failure.position < stream.data() + trailing)
+            {
+                failure.reset();
+                failure.fail(stream.data() + trailing, nullptr);
+            }
+            last_error() = failure.describe(input);
+        }
+        return true;
+    }
+    if (Nesting::current().exceeded)
+    {
+        last_error() = "nested deeper than " + std::to_string(nesting_limit);
+    }
+    else
+    {
+        last_error() = failure.describe(input);
+    }
+    return false;
+}
 
 bool parse(std::string_view &stream)
 {
-    const bool result = Parsers::exper(stream);
-    importer.solve();
-    return result;
+    Importer importer;
+    if (!run(stream, importer, false))
+    {
+        std::cout << last_error() << std::endl;
+        return false;
+    }
+    std::cout << "= " << importer.result() << std::endl;
+    return true;
 }
 
 bool parse(std::ifstream &stream)
 {
-    std::stringstream sstream;
-    sstream << stream.rdbuf();
-    std::string str(sstream.str());
+    // the expression starts where the caller left the stream, a header already read is skipped
+    std::string str;
+    std::streamoff size = -1;
+    const std::streampos start = stream.tellg();
+    if (start >= 0 && stream.seekg(0, std::ios::end))
+    {
+        size = stream.tellg() - start;
+        stream.seekg(start);
+    }
+    if (size > 0)
+    {
+        str.resize(static_cast<size_t>(size));
+        stream.read(str.data(), size);
+        str.resize(static_cast<size_t>(stream.gcount()));
+    }
+    else
+    {
+        str.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
     std::string_view temp(str);
-    return Parsers::exper(temp);
+    Importer importer;
+    return run(temp, importer, true);
+}
+
+bool parse_file(const std::string &path)
+{
+    const FileSource file(path);
+    if (!file.is_open())
+    {
+        last_error() = "cannot open " + path;
+        return false;
+    }
+    std::string_view temp(file.view());
+    Importer importer;
+    return run(temp, importer, true);
+}
+
+const std::string &error()
+{
+    return last_error();
+}
+
+size_t max_nesting()
+{
+    return nesting_limit;
+}
+
+void set_max_nesting(const size_t limit)
+{
+    nesting_limit = limit;
 }
 
 
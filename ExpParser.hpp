@@ -2,8 +2,9 @@
 #include <string>
 #include <fstream>
 #include <stack>
-#include <variant>
 #include "Parser/ParserGen2.hpp"
+#include "Parser/Expression.hpp"
+#include "Parser/FileSource.hpp"
 
 
 namespace ExpParser
@@ -12,9 +13,10 @@ namespace ExpParser
 class Importer
 {
 private:
-    enum Operator {ADD, SUB, MUL, DIV};
-    std::stack<std::variant<double, Operator>> _expression;
-    std::vector<std::variant<double, Operator>> _cache;
+    // operands in postfix order, every operator replaces the top two with its result
+    std::stack<double> _values;
+
+    double pop();
 
 public:
     void add();
@@ -27,16 +29,29 @@ public:
 
     void num(const int value);
 
-    void solve();
+    double result() const;
 };
 
+// built once and shared, every parse runs its actions on its own Importer
 struct Parsers
 {
-    static Parser<bool> exper, term, factor;
+    static Parser<bool> factor, exper;
 };
 
 bool parse(std::string_view &stream);
 
 bool parse(std::ifstream &stream);
 
+bool parse_file(const std::string &path);
+
+// why the last parse on this thread failed, "line 1, column 6: expected ..."; empty after a success,
+// except when a stream or file parse stopped before trailing input, which it describes
+const std::string &error();
+
+// how deep parentheses may nest, 200 by default; deeper input fails with an error instead of
+// overflowing the stack. Raise it only with a larger stack, and not while another thread parses.
+size_t max_nesting();
+
+void set_max_nesting(const size_t limit);
+
 };
\ No newline at end of file
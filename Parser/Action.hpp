@@ -1,208 +1,533 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <functional>
 
 
+// Per-parse state for semantic actions.
+// A grammar is built once and only read while parsing, so it can be shared between threads;
+// the state a parse writes to is installed for the calling thread with Context<S>::Scope,
+// and actions built from a member function, Action(&S::member), call it on that state.
+template <typename S>
+struct Context
+{
+    static S *&current()
+    {
+        thread_local S *state = nullptr;
+        return state;
+    }
+
+    // makes state the current S of this thread until the scope ends
+    class Scope
+    {
+    private:
+        S *_previous;
+
+    public:
+        Scope(S &state)
+            : _previous(current())
+        {
+            current() = &state;
+        }
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+        ~Scope()
+        {
+            current() = _previous;
+        }
+    };
+};
+
 template <typename N>
 struct Action
 {
+    using Thunk = void (*)(void *, const N &);
+
     std::function<void(const N &)> func;
+    // set by action<F>(), a plain function pointer used instead of func
+    Thunk thunk = nullptr;
+    void *object = nullptr;
 
     Action() {};
 
     Action(const Action<N> &action)
-        : func(action.func) {};
+        : func(action.func), thunk(action.thunk), object(action.object) {};
 
     template <typename T>
     Action(T *s, void (T::*f)(const N &))
         : func(std::bind(f, s)) {};
 
+    // calls f on the Context<T> of the parsing thread, does nothing outside a context
+    template <typename T>
+    Action(void (T::*f)(const N &))
+        : func([f](const N &value)
+            {
+                if (T *s = Context<T>::current())
+                {
+                    (s->*f)(value);
+                }
+            }) {};
+
     Action(const std::function<void(const N &)> f)
         : func(f) {};
 
+    Action(const Thunk t, void *o)
+        : thunk(t), object(o) {};
+
     inline void operator()(const N &value) const
     {
+        if (thunk != nullptr)
+        {
+            return thunk(object, value);
+        }
         return func(value);
     }
 
     Action<N> &operator=(const std::function<void(const N &)> &f)
     {
         func = f;
+        thunk = nullptr;
         return *this;
     }
 
     operator bool() const
     {
-        return bool(func);
+        return thunk != nullptr || bool(func);
     }
 };
 
 template <>
 struct Action<void>
 {
+    using Thunk = void (*)(void *);
+
     std::function<void(void)> func;
+    // set by action<F>(), a plain function pointer used instead of func
+    Thunk thunk = nullptr;
+    void *object = nullptr;
 
     Action() {};
 
     Action(const Action<void> &action)
-        : func(action.func) {};
+        : func(action.func), thunk(action.thunk), object(action.object) {};
 
     template <typename T>
     Action(T *s, void (T::*f)(void))
         : func(std::bind(f, s)) {};
 
+    template <typename T>
+    Action(void (T::*f)(void))
+        : func([f]()
+            {
+                if (T *s = Context<T>::current())
+                {
+                    (s->*f)();
+                }
+            }) {};
+
     Action(const std::function<void(void)> f)
         : func(f) {};
 
+    Action(const Thunk t, void *o)
+        : thunk(t), object(o) {};
+
     inline void operator()() const
     {
+        if (thunk != nullptr)
+        {
+            return thunk(object);
+        }
         return func();
     }
 
     Action<void> &operator=(const std::function<void(void)> &f)
     {
         func = f;
+        thunk = nullptr;
         return *this;
     }
 
     operator bool() const
     {
-        return bool(func);
+        return thunk != nullptr || bool(func);
     }
 };
 
 template <>
 struct Action<std::string>
 {
+    using Thunk = void (*)(void *, const std::string &);
+
     std::function<void(const std::string &)> func;
+    // set by action<F>(), a plain function pointer used instead of func
+    Thunk thunk = nullptr;
+    void *object = nullptr;
 
     Action() {};
 
     Action(const Action<std::string> &action)
-        : func(action.func) {};
+        : func(action.func), thunk(action.thunk), object(action.object) {};
 
     template <typename T>
     Action(T *s, void (T::*f)(const std::string &))
         : func(std::bind(f, s, std::placeholders::_1)) {};
 
+    template <typename T>
+    Action(void (T::*f)(const std::string &))
+        : func([f](const std::string &value)
+            {
+                if (T *s = Context<T>::current())
+                {
+                    (s->*f)(value);
+                }
+            }) {};
+
     Action(const std::function<void(const std::string &)> f)
         : func(f) {};
 
+    Action(const Thunk t, void *o)
+        : thunk(t), object(o) {};
+
     inline void operator()(const std::string &value) const
     {
+        if (thunk != nullptr)
+        {
+            return thunk(object, value);
+        }
         return func(value);
     }
 
     Action<std::string> &operator=(const std::function<void(const std::string &)> &f)
     {
         func = f;
+        thunk = nullptr;
         return *this;
     }
 
     operator bool() const
     {
-        return bool(func);
+        return thunk != nullptr || bool(func);
+    }
+};
+
+template <>
+struct Action<std::string_view>
+{
+    using Thunk = void (*)(void *, const std::string_view &);
+
+    std::function<void(const std::string_view)> func;
+    // set by action<F>(), a plain function pointer used instead of func
+    Thunk thunk = nullptr;
+    void *object = nullptr;
+
+    Action() {};
+
+    Action(const Action<std::string_view> &action)
+        : func(action.func), thunk(action.thunk), object(action.object) {};
+
+    template <typename T>
+    Action(T *s, void (T::*f)(const std::string_view))
+        : func(std::bind(f, s, std::placeholders::_1)) {};
+
+    template <typename T>
+    Action(void (T::*f)(const std::string_view))
+        : func([f](const std::string_view value)
+            {
+                if (T *s = Context<T>::current())
+                {
+                    (s->*f)(value);
+                }
+            }) {};
+
+    Action(const std::function<void(const std::string_view)> f)
+        : func(f) {};
+
+    Action(const Thunk t, void *o)
+        : thunk(t), object(o) {};
+
+    inline void operator()(const std::string_view value) const
+    {
+        if (thunk != nullptr)
+        {
+            return thunk(object, value);
+        }
+        return func(value);
+    }
+
+    Action<std::string_view> &operator=(const std::function<void(const std::string_view)> &f)
+    {
+        func = f;
+        thunk = nullptr;
+        return *this;
+    }
+
+    operator bool() const
+    {
+        return thunk != nullptr || bool(func);
     }
 };
 
 template <>
 struct Action<char>
 {
+    using Thunk = void (*)(void *, const char &);
+
     std::function<void(const char)> func;
+    // set by action<F>(), a plain function pointer used instead of func
+    Thunk thunk = nullptr;
+    void *object = nullptr;
 
     Action() {};
 
     Action(const Action<char> &action)
-        : func(action.func) {};
+        : func(action.func), thunk(action.thunk), object(action.object) {};
 
     template <typename T>
     Action(T *s, void (T::*f)(const char))
         : func(std::bind(f, s, std::placeholders::_1)) {};
 
+    template <typename T>
+    Action(void (T::*f)(const char))
+        : func([f](const char value)
+            {
+                if (T *s = Context<T>::current())
+                {
+                    (s->*f)(value);
+                }
+            }) {};
+
     Action(const std::function<void(const char)> f)
         : func(f) {};
 
+    Action(const Thunk t, void *o)
+        : thunk(t), object(o) {};
+
     inline void operator()(const char value) const
     {
+        if (thunk != nullptr)
+        {
+            return thunk(object, value);
+        }
         return func(value);
     }
 
     Action<char> &operator=(const std::function<void(const char)> &f)
     {
         func = f;
+        thunk = nullptr;
         return *this;
     }
 
     operator bool() const
     {
-        return bool(func);
+        return thunk != nullptr || bool(func);
     }
 };
 
 template <>
 struct Action<double>
 {
+    using Thunk = void (*)(void *, const double &);
+
     std::function<void(const double)> func;
+    // set by action<F>(), a plain function pointer used instead of func
+    Thunk thunk = nullptr;
+    void *object = nullptr;
 
     Action() {};
 
     Action(const Action<double> &action)
-        : func(action.func) {};
+        : func(action.func), thunk(action.thunk), object(action.object) {};
 
     template <typename T>
     Action(T *s, void (T::*f)(const double))
         : func(std::bind(f, s, std::placeholders::_1)) {};
 
+    template <typename T>
+    Action(void (T::*f)(const double))
+        : func([f](const double value)
+            {
+                if (T *s = Context<T>::current())
+                {
+                    (s->*f)(value);
+                }
+            }) {};
+
     Action(const std::function<void(const double)> f)
         : func(f) {};
 
+    Action(const Thunk t, void *o)
+        : thunk(t), object(o) {};
+
     inline void operator()(const double value) const
     {
+        if (thunk != nullptr)
+        {
+            return thunk(object, value);
+        }
         return func(value);
     }
 
     Action<double> &operator=(const std::function<void(const double)> &f)
     {
         func = f;
+        thunk = nullptr;
         return *this;
     }
 
     operator bool() const
     {
-        return bool(func);
+        return thunk != nullptr || bool(func);
     }
 };
 
 template <>
 struct Action<int>
 {
+    using Thunk = void (*)(void *, const int &);
+
     std::function<void(const int)> func;
+    // set by action<F>(), a plain function pointer used instead of func
+    Thunk thunk = nullptr;
+    void *object = nullptr;
 
     Action() {};
 
     Action(const Action<int> &action)
-        : func(action.func) {};
+        : func(action.func), thunk(action.thunk), object(action.object) {};
 
     template <typename T>
     Action(T *s, void (T::*f)(const int))
         : func(std::bind(f, s, std::placeholders::_1)) {};
 
+    template <typename T>
+    Action(void (T::*f)(const int))
+        : func([f](const int value)
+            {
+                if (T *s = Context<T>::current())
+                {
+                    (s->*f)(value);
+                }
+            }) {};
+
     Action(const std::function<void(const int)> f)
         : func(f) {};
 
+    Action(const Thunk t, void *o)
+        : thunk(t), object(o) {};
+
     inline void operator()(const int value) const
     {
+        if (thunk != nullptr)
+        {
+            return thunk(object, value);
+        }
         return func(value);
     }
 
     Action<int> &operator=(const std::function<void(const int)> &f)
     {
         func = f;
+        thunk = nullptr;
         return *this;
     }
 
     operator bool() const
     {
-        return bool(func);
+        return thunk != nullptr || bool(func);
     }
-};
\ No newline at end of file
+};
+
+template <typename F>
+struct ActionTraits;
+
+template <typename T>
+struct ActionTraits<void (T::*)(void)>
+{
+    using Value = void;
+    using Class = T;
+};
+
+template <typename T, typename A>
+struct ActionTraits<void (T::*)(A)>
+{
+    using Value = std::decay_t<A>;
+    using Class = T;
+};
+
+template <typename T>
+struct ActionTraits<void (T::*)(void) const>
+{
+    using Value = void;
+    using Class = T;
+};
+
+template <typename T, typename A>
+struct ActionTraits<void (T::*)(A) const>
+{
+    using Value = std::decay_t<A>;
+    using Class = T;
+};
+
+template <>
+struct ActionTraits<void (*)(void)>
+{
+    using Value = void;
+    using Class = void;
+};
+
+template <typename A>
+struct ActionTraits<void (*)(A)>
+{
+    using Value = std::decay_t<A>;
+    using Class = void;
+};
+
+// an Action whose callee F is a template argument, so the call inlines into a small thunk
+// and firing the action is a single call through a function pointer, with no std::function
+// or std::bind in between. F is a free function or a member function; a member function
+// runs on object, or on the Context of the parsing thread when object is nullptr.
+//     int_p()[action<&Importer::num>()]
+template <auto F>
+Action<typename ActionTraits<decltype(F)>::Value> action(typename ActionTraits<decltype(F)>::Class *object = nullptr)
+{
+    using Class = typename ActionTraits<decltype(F)>::Class;
+    using Value = typename ActionTraits<decltype(F)>::Value;
+    const typename Action<Value>::Thunk thunk = [](void *target, const auto &...value)
+    {
+        if constexpr(std::is_void<Class>::value)
+        {
+            F(value...);
+        }
+        else
+        {
+            Class *self = target != nullptr ? static_cast<Class *>(target) : Context<Class>::current();
+            if (self != nullptr)
+            {
+                (self->*F)(value...);
+            }
+        }
+    };
+    return Action<Value>(thunk, object);
+}
+
+// the same for a captureless lambda or an empty function object, which C++17 does not accept
+// as a template argument. Such a callee has no state, its type alone says what to call, so the
+// thunk calls a copy kept once per type. Callees with state need Action(std::function).
+//     int_p()[action([](const int value) { std::cout << value; })]
+template <typename F, typename = std::enable_if_t<std::is_class<F>::value>>
+Action<typename ActionTraits<decltype(&F::operator())>::Value> action(const F &f)
+{
+    static_assert(std::is_empty<F>::value,
+        "action(f) takes a captureless lambda or an empty function object, use Action(std::function) for state");
+    using Value = typename ActionTraits<decltype(&F::operator())>::Value;
+    static F callee = f;
+    const typename Action<Value>::Thunk thunk = [](void *, const auto &...value)
+    {
+        callee(value...);
+    };
+    return Action<Value>(thunk, nullptr);
+}
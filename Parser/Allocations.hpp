@@ -0,0 +1,162 @@
+#pragma once
+#include <cstdlib>
+#include <new>
+#include "Profile.hpp"
+
+
+// Heap allocation counter, replacing the global operator new and delete.
+// Every form is replaced, plain, array, nothrow and aligned, so each block is released by
+// the family that allocated it. Include it in exactly one translation unit of a program:
+// benchmarks read or reset allocations around the code they measure, and with
+// PARSER_INSTRUMENT every allocation is also charged to the innermost name_p rule.
+// The operators are kept out of line: GCC otherwise sees malloc() or free() inlined into
+// the caller, pairs it with the other operator and warns with -Wmismatched-new-delete.
+
+inline size_t allocations = 0;
+
+namespace Heap
+{
+
+inline void *allocate(const size_t size) noexcept
+{
+    ++allocations;
+#ifdef PARSER_INSTRUMENT
+    profile_allocation();
+#endif
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+inline void *allocate(const size_t size, const std::align_val_t alignment) noexcept
+{
+    ++allocations;
+#ifdef PARSER_INSTRUMENT
+    profile_allocation();
+#endif
+    const size_t align = static_cast<size_t>(alignment);
+    // aligned_alloc wants a whole number of alignments
+    return std::aligned_alloc(align, size == 0 ? align : (size + align - 1) / align * align);
+}
+
+};
+
+#if defined(__GNUC__)
+#define PARSER_ALLOCATION_NOINLINE __attribute__((noinline))
+#else
+#define PARSER_ALLOCATION_NOINLINE
+#endif
+
+PARSER_ALLOCATION_NOINLINE void *operator new(const size_t size)
+{
+    if (void *ptr = Heap::allocate(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+PARSER_ALLOCATION_NOINLINE void *operator new[](const size_t size)
+{
+    if (void *ptr = Heap::allocate(size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+PARSER_ALLOCATION_NOINLINE void *operator new(const size_t size, const std::align_val_t alignment)
+{
+    if (void *ptr = Heap::allocate(size, alignment))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+PARSER_ALLOCATION_NOINLINE void *operator new[](const size_t size, const std::align_val_t alignment)
+{
+    if (void *ptr = Heap::allocate(size, alignment))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+PARSER_ALLOCATION_NOINLINE void *operator new(const size_t size, const std::nothrow_t &) noexcept
+{
+    return Heap::allocate(size);
+}
+
+PARSER_ALLOCATION_NOINLINE void *operator new[](const size_t size, const std::nothrow_t &) noexcept
+{
+    return Heap::allocate(size);
+}
+
+PARSER_ALLOCATION_NOINLINE void *operator new(const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return Heap::allocate(size, alignment);
+}
+
+PARSER_ALLOCATION_NOINLINE void *operator new[](const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return Heap::allocate(size, alignment);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete(void *ptr, size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete[](void *ptr, size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+PARSER_ALLOCATION_NOINLINE void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
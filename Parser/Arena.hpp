@@ -0,0 +1,109 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+
+// Bump-pointer allocator for objects that live as long as one parse.
+// Memory comes from a list of blocks that are kept across reset(), so after the first parse
+// allocation is a pointer increment and freeing everything is O(1). Objects are never
+// destroyed, which is why only trivially destructible types can be made here.
+// mark()/rewind() drop everything allocated since the mark, e.g. by a failed alternative.
+
+class Arena
+{
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> _blocks;
+    size_t _block_size;
+    // block being filled and the first free byte in it
+    size_t _block = 0;
+    size_t _offset = 0;
+
+public:
+    struct Mark
+    {
+        size_t block;
+        size_t offset;
+    };
+
+    Arena(const size_t block_size = 1 << 16)
+        : _block_size(block_size > 0 ? block_size : 1) {}
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(const size_t size, const size_t align)
+    {
+        for (;;)
+        {
+            if (_block < _blocks.size())
+            {
+                const size_t offset = (_offset + align - 1) & ~(align - 1);
+                if (offset + size <= _blocks[_block].size)
+                {
+                    _offset = offset + size;
+                    return _blocks[_block].data.get() + offset;
+                }
+                if (_block + 1 == _blocks.size() || _blocks[_block + 1].size < size + align)
+                {
+                    // the next block is too small for this object, a new one goes in its place
+                    const size_t length = std::max(_block_size, size + align);
+                    _blocks.insert(_blocks.begin() + _block + 1, Block{std::make_unique<char[]>(length), length});
+                }
+                ++_block;
+            }
+            else
+            {
+                const size_t length = std::max(_block_size, size + align);
+                _blocks.push_back(Block{std::make_unique<char[]>(length), length});
+                _block = _blocks.size() - 1;
+            }
+            _offset = 0;
+        }
+    }
+
+    template <typename T, typename... A>
+    T *make(A &&...args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T{std::forward<A>(args)...};
+    }
+
+    Mark mark() const
+    {
+        return Mark{_block, _offset};
+    }
+
+    void rewind(const Mark &mark)
+    {
+        _block = mark.block;
+        _offset = mark.offset;
+    }
+
+    // frees every object at once, the blocks are kept for the next parse
+    void reset()
+    {
+        _block = 0;
+        _offset = 0;
+    }
+
+    // bytes reserved from the heap
+    size_t capacity() const
+    {
+        size_t result = 0;
+        for (const Block &block : _blocks)
+        {
+            result += block.size;
+        }
+        return result;
+    }
+};
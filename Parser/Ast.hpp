@@ -0,0 +1,219 @@
+#pragma once
+#include "Action.hpp"
+#include "Arena.hpp"
+#include "BaseParser.hpp"
+
+
+// AST output mode that works with either generator.
+// ast_p(kind, parser) records a node for every match of parser: its kind, the matched slice
+// of the input and the nodes of the ast_p rules matched inside it as children. The nodes are
+// allocated in the Arena of the AstBuilder installed with Context<AstBuilder>::Scope, and the
+// rule's own result is moved into the node when it is trivially destructible (int, double,
+// char, string_view, tuples of them ...). The parser returns the node pointer, so enclosing
+// tuples, variants and vectors only carry pointers instead of copies of the subtrees.
+// The whole tree is freed in O(1) by AstBuilder::reset() or with the builder.
+// The input must outlive the tree. Without a builder ast_p matches like parser and returns nullptr.
+// A failed ast_p rewinds the arena. Nodes of a branch that succeeded and was backtracked over
+// by an enclosing combinator are recognised by position: a node is dropped when a later
+// sibling starts before its end, or when it ends past its parent. The root has no end of its
+// own, so call finish() with the unconsumed input after the top-level parse to prune it too.
+// If such a branch may be followed by text without nodes over the same span, wrap the branch
+// itself in ast_p.
+
+struct AstNode
+{
+    int kind = 0;
+    std::string_view text;
+    AstNode *first_child = nullptr;
+    AstNode *last_child = nullptr;
+    AstNode *next_sibling = nullptr;
+    AstNode *previous_sibling = nullptr;
+
+    // the result of the rule, only for nodes made by ast_p over a Parser<T> with such a result
+    template <typename T>
+    const T &value() const;
+};
+
+template <typename T>
+struct AstValue : AstNode
+{
+    T value;
+};
+
+template <typename T>
+const T &AstNode::value() const
+{
+    return static_cast<const AstValue<T> *>(this)->value;
+}
+
+class AstBuilder
+{
+private:
+    Arena _arena;
+    AstNode _root;
+    AstNode *_open = &_root;
+
+    // a node starting before the end of the last child means the parser backtracked
+    // over that child, such stale children are dropped
+    static void drop_after(AstNode &parent, const char *position)
+    {
+        while (parent.last_child != nullptr
+            && parent.last_child->text.data() + parent.last_child->text.length() > position)
+        {
+            parent.last_child = parent.last_child->previous_sibling;
+            if (parent.last_child == nullptr)
+            {
+                parent.first_child = nullptr;
+            }
+            else
+            {
+                parent.last_child->next_sibling = nullptr;
+            }
+        }
+    }
+
+public:
+    AstBuilder(const size_t block_size = 1 << 16)
+        : _arena(block_size) {}
+
+    AstBuilder(const AstBuilder &) = delete;
+
+    AstBuilder &operator=(const AstBuilder &) = delete;
+
+    // the top-level nodes are the children of root()
+    const AstNode &root() const
+    {
+        return _root;
+    }
+
+    Arena &arena()
+    {
+        return _arena;
+    }
+
+    // drops the top-level nodes that end past rest, the input the top-level parse left over:
+    // they were matched by a branch that was backtracked over afterwards
+    //     std::string_view stream(input);
+    //     grammar(stream);
+    //     builder.finish(stream);
+    void finish(const std::string_view rest)
+    {
+        drop_after(_root, rest.data());
+    }
+
+    void reset()
+    {
+        _arena.reset();
+        _root = AstNode();
+        _open = &_root;
+    }
+
+    // used by ast_p
+    AstNode *open(AstNode *node)
+    {
+        AstNode *parent = _open;
+        _open = node;
+        return parent;
+    }
+
+    void close(AstNode *parent, AstNode *node)
+    {
+        _open = parent;
+        if (node == nullptr)
+        {
+            return;
+        }
+        drop_after(*node, node->text.data() + node->text.length());
+        drop_after(*parent, node->text.data());
+        node->previous_sibling = parent->last_child;
+        if (parent->last_child == nullptr)
+        {
+            parent->first_child = node;
+        }
+        else
+        {
+            parent->last_child->next_sibling = node;
+        }
+        parent->last_child = node;
+    }
+};
+
+namespace detail
+{
+
+template <typename T, typename P>
+Parser<AstNode *> ast_p(const int kind, const P &parser)
+{
+    using Node = std::conditional_t<!std::is_same<T, bool>::value && std::is_trivially_destructible<T>::value
+        && std::is_default_constructible<T>::value, AstValue<T>, AstNode>;
+    return Parser<AstNode *>(std::function<std::optional<AstNode *>(std::string_view &)>(
+        [=](std::string_view &stream) -> std::optional<AstNode *>
+        {
+            AstBuilder *builder = Context<AstBuilder>::current();
+            if (builder == nullptr)
+            {
+                std::string_view stream_copy(stream);
+                bool matched;
+                if constexpr(std::is_same<T, bool>::value)
+                {
+                    matched = parser(stream_copy);
+                }
+                else
+                {
+                    matched = parser(stream_copy).has_value();
+                }
+                if (!matched)
+                {
+                    return std::nullopt;
+                }
+                stream = stream_copy;
+                return nullptr;
+            }
+
+            const Arena::Mark mark = builder->arena().mark();
+            Node *node = builder->arena().make<Node>();
+            node->kind = kind;
+            AstNode *parent = builder->open(node);
+            const std::string_view start(stream);
+            bool matched;
+            if constexpr(std::is_same<T, bool>::value)
+            {
+                matched = parser(stream);
+            }
+            else
+            {
+                std::optional<T> result = parser(stream);
+                matched = result.has_value();
+                if constexpr(!std::is_same<Node, AstNode>::value)
+                {
+                    if (matched)
+                    {
+                        node->value = std::move(result.value());
+                    }
+                }
+            }
+            if (!matched)
+            {
+                builder->close(parent, nullptr);
+                builder->arena().rewind(mark);
+                return std::nullopt;
+            }
+            node->text = start.substr(0, start.length() - stream.length());
+            builder->close(parent, node);
+            return node;
+        }));
+}
+
+};
+
+template <typename T>
+inline Parser<AstNode *> ast_p(const int kind, const Parser<T> &parser)
+{
+    return detail::ast_p<T>(kind, parser);
+}
+
+template <typename T>
+inline Parser<AstNode *> ast_p(const int kind, const std::reference_wrapper<Parser<T>> &parser)
+{
+    return detail::ast_p<T>(kind, parser);
+}
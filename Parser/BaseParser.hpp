@@ -2,25 +2,133 @@
 
 #include <string_view>
 #include <optional>
+#include <memory>
 #include <vector>
+#include <charconv>
+#include <cstdint>
 #include "Action.hpp"
+#include "Failure.hpp"
+#include "Scan.hpp"
+#include "Profile.hpp"
 
 
+// Cut points passed on this thread, see cut_p.
+// A choice point (|, !, * and + without a value) reads passed before it tries an alternative;
+// when the alternative fails and passed has changed, a cut was passed inside it and the choice
+// point fails as well instead of backtracking past the cut.
+struct Cut
+{
+    size_t passed = 0;
+    // where the latest cut was passed
+    const char *position = nullptr;
+
+    static Cut &current()
+    {
+        static thread_local Cut cut;
+        return cut;
+    }
+};
+
+// First-byte dispatch for an alternation chain a | b | c ..., built by operator|.
+// Branches keep their order, but for a given leading byte only the branches whose FIRST set
+// contains it are tried; a branch with an unknown FIRST set is tried for every byte.
+template <typename T>
+struct Alternation
+{
+    using Result = std::conditional_t<std::is_same<T, bool>::value, bool, std::optional<T>>;
+    using Branch = std::function<Result(std::string_view &)>;
+
+    std::vector<Branch> branches;
+    std::vector<std::shared_ptr<const CharSet>> firsts;
+    // branch indices to try for each leading byte, slot 256 is the empty stream
+    std::vector<uint16_t> order;
+    uint32_t offsets[258] = {};
+
+    void add(const Branch &branch, const std::shared_ptr<const CharSet> &first)
+    {
+        branches.push_back(branch);
+        firsts.push_back(first);
+    }
+
+    void append(const Alternation<T> &other)
+    {
+        branches.insert(branches.end(), other.branches.begin(), other.branches.end());
+        firsts.insert(firsts.end(), other.firsts.begin(), other.firsts.end());
+    }
+
+    void build()
+    {
+        order.clear();
+        for (size_t slot = 0; slot < 257; ++slot)
+        {
+            offsets[slot] = static_cast<uint32_t>(order.size());
+            for (size_t i = 0; i < branches.size(); ++i)
+            {
+                if (firsts[i] == nullptr || (slot < 256 && firsts[i]->test(static_cast<char>(slot))))
+                {
+                    order.push_back(static_cast<uint16_t>(i));
+                }
+            }
+        }
+        offsets[257] = static_cast<uint32_t>(order.size());
+    }
+
+    // union of the branches' FIRST sets, nullptr if any of them is unknown
+    std::shared_ptr<const CharSet> first() const
+    {
+        CharSet result;
+        for (const std::shared_ptr<const CharSet> &first : firsts)
+        {
+            if (first == nullptr)
+            {
+                return nullptr;
+            }
+            result = result | *first;
+        }
+        return std::make_shared<const CharSet>(result);
+    }
+
+    Result operator()(std::string_view &stream) const
+    {
+        const size_t slot = stream.empty() ? 256 : static_cast<unsigned char>(stream.front());
+        const Cut &cut = Cut::current();
+        const size_t passed = cut.passed;
+        for (uint32_t i = offsets[slot]; i < offsets[slot + 1]; ++i)
+        {
+            Result result = branches[order[i]](stream);
+            if (result || cut.passed != passed)
+            {
+                return result;
+            }
+        }
+        return Result();
+    }
+};
+
+// Every parser may carry a FIRST set: when set, a match consumes at least one byte
+// and starts with a byte of the set. Actions leave it unchanged.
+
 template <typename T>
 struct Parser
 {
     std::function<std::optional<T>(std::string_view &)> func;
     Action<void> call;
+    std::shared_ptr<const CharSet> first;
 
     Parser(const std::function<std::optional<T>(std::string_view &)> &f)
         : func(f) {}
 
     Parser(const Parser<T> &parser)
-        : func(parser.func), call(parser.call) {}
+        : func(parser.func), call(parser.call), first(parser.first) {}
 
     inline std::optional<T> operator()(std::string_view &stream) const
     {
         std::optional<T> result = this->func(stream);
+        PARSER_PROFILE_CALL(result.has_value());
+        if (!result.has_value())
+        {
+            track_failure(stream, this->first.get());
+        }
         if (result.has_value() && this->call)
         {
             this->call();
@@ -28,7 +136,7 @@ struct Parser
         return result;
     }
 
-    Parser<T> &operator[](Action<void> &action)
+    Parser<T> &operator[](const Action<void> &action)
     {
         call = action;
         return *this;
@@ -46,6 +154,9 @@ struct Parser<bool>
 {
     std::function<bool(std::string_view &)> func;
     Action<void> call;
+    std::shared_ptr<const CharSet> first;
+    // set when this is an alternation chain, operator| extends it instead of nesting
+    std::shared_ptr<const Alternation<bool>> alternation;
 
     Parser(const std::function<bool(std::string_view &)> &f)
         : func(f) {};
@@ -54,14 +165,16 @@ struct Parser<bool>
 
     template <typename T>
     Parser(const Parser<T> &parser)
-        : func([=](std::string_view &stream){return parser.func(stream).has_value();}), call(parser.call) {}
+        : func([=](std::string_view &stream){return parser(stream).has_value();}), first(parser.first) {}
 
     Parser(const Parser<bool> &parser)
-        : func(parser.func), call(parser.call) {}
+        : func(parser.func), call(parser.call), first(parser.first), alternation(parser.alternation) {}
 
     inline bool operator()(std::string_view &stream) const
     {
-        if (this->func(stream))
+        const bool result = this->func(stream);
+        PARSER_PROFILE_CALL(result);
+        if (result)
         {
             if (this->call)
             {
@@ -71,11 +184,12 @@ struct Parser<bool>
         }
         else
         {
+            track_failure(stream, this->first.get());
             return false;
         }
     }
 
-    Parser<bool> &operator[](Action<void> &action)
+    Parser<bool> &operator[](const Action<void> &action)
     {
         call = action;
         return *this;
@@ -94,6 +208,10 @@ struct Parser<std::string>
     std::function<std::optional<std::string>(std::string_view &)> func;
     Action<void> void_call;
     Action<std::string> call;
+    // the matched text when this is a plain str_p, lets combinators scan for it directly
+    std::string literal;
+    std::shared_ptr<const CharSet> first;
+    std::shared_ptr<const Alternation<std::string>> alternation;
 
     Parser(const std::function<std::optional<std::string>(std::string_view &)> &f)
         : func(f) {}
@@ -110,14 +228,21 @@ struct Parser<std::string>
             {
                 return std::nullopt;
             }
-        }) {}
+        }), literal(value), first(value.empty() ? nullptr : std::make_shared<const CharSet>(value.substr(0, 1))) {}
 
     Parser(const Parser<std::string> &parser)
-        : func(parser.func), call(parser.call), void_call(parser.void_call) {}
+        : func(parser.func), void_call(parser.void_call), call(parser.call), literal(parser.literal),
+        first(parser.first), alternation(parser.alternation) {}
 
     std::optional<std::string> operator()(std::string_view &stream) const
     {
-        const std::optional<std::string> result = this->func(stream);
+        std::optional<std::string> result = this->func(stream);
+        PARSER_PROFILE_CALL(result.has_value());
+        if (!result.has_value())
+        {
+            track_failure(stream, this->first.get());
+        }
+        PARSER_PROFILE_COPY(result.has_value() ? result.value().length() : 0);
         if (result.has_value())
         {
             if (this->void_call)
@@ -132,7 +257,7 @@ struct Parser<std::string>
         return result;
     }
 
-    Parser<std::string> &operator[](Action<void> &action)
+    Parser<std::string> &operator[](const Action<void> &action)
     {
         void_call = action;
         return *this;
@@ -144,7 +269,7 @@ struct Parser<std::string>
         return *this;
     }
 
-    Parser<std::string> &operator[](Action<std::string> &action)
+    Parser<std::string> &operator[](const Action<std::string> &action)
     {
         call = action;
         return *this;
@@ -157,12 +282,99 @@ struct Parser<std::string>
     }
 };
 
+// zero-copy counterpart of Parser<std::string>, results are slices of the input
+template <>
+struct Parser<std::string_view>
+{
+    std::function<std::optional<std::string_view>(std::string_view &)> func;
+    Action<void> void_call;
+    Action<std::string_view> call;
+    std::string literal;
+    // set when every match is a run of this class, see raw_p
+    std::shared_ptr<const CharSet> charset;
+    std::shared_ptr<const CharSet> first;
+
+    Parser(const std::function<std::optional<std::string_view>(std::string_view &)> &f)
+        : func(f) {}
+
+    Parser(const std::string_view value)
+        : func([value = std::string(value)](std::string_view &stream) -> std::optional<std::string_view>
+        {
+            if (stream.length() >= value.length() && stream.compare(0, value.length(), value) == 0)
+            {
+                const std::string_view result = stream.substr(0, value.length());
+                stream.remove_prefix(value.length());
+                return result;
+            }
+            else
+            {
+                return std::nullopt;
+            }
+        }), literal(value),
+        first(value.empty() ? nullptr : std::make_shared<const CharSet>(std::string_view(value.data(), 1))) {}
+
+    Parser(const Parser<std::string_view> &parser)
+        : func(parser.func), void_call(parser.void_call), call(parser.call), literal(parser.literal),
+        charset(parser.charset), first(parser.first) {}
+
+    std::optional<std::string_view> operator()(std::string_view &stream) const
+    {
+        std::optional<std::string_view> result = this->func(stream);
+        PARSER_PROFILE_CALL(result.has_value());
+        if (!result.has_value())
+        {
+            track_failure(stream, this->first.get());
+        }
+        if (result.has_value())
+        {
+            if (this->void_call)
+            {
+                this->void_call();
+            }
+            else if (this->call)
+            {
+                this->call(result.value());
+            }
+        }
+        return result;
+    }
+
+    Parser<std::string_view> &operator[](const Action<void> &action)
+    {
+        void_call = action;
+        return *this;
+    }
+
+    Parser<std::string_view> &operator[](const std::function<void(void)> &f)
+    {
+        void_call = f;
+        return *this;
+    }
+
+    Parser<std::string_view> &operator[](const Action<std::string_view> &action)
+    {
+        call = action;
+        return *this;
+    }
+
+    Parser<std::string_view> &operator[](const std::function<void(const std::string_view)> &f)
+    {
+        call = f;
+        return *this;
+    }
+};
+
 template <>
 struct Parser<char>
 {
     std::function<std::optional<char>(std::string_view &)> func;
     Action<void> void_call;
     Action<char> call;
+    // the matched character when this is a plain ch_p
+    std::string literal;
+    // set when the parser matches exactly one byte of this class, lets * and + scan whole runs
+    std::shared_ptr<const CharSet> charset;
+    std::shared_ptr<const CharSet> first;
 
     Parser(const std::function<std::optional<char>(std::string_view &)> &f)
         : func(f) {}
@@ -180,14 +392,20 @@ struct Parser<char>
                     return std::nullopt;
                 }
             }
-        ) {}
+        ), literal(1, value), charset(std::make_shared<const CharSet>(std::string_view(&value, 1))), first(charset) {}
 
     Parser(const Parser<char> &parser)
-        : func(parser.func), call(parser.call), void_call(parser.void_call) {}
+        : func(parser.func), void_call(parser.void_call), call(parser.call), literal(parser.literal),
+        charset(parser.charset), first(parser.first) {}
 
     std::optional<char> operator()(std::string_view &stream) const
     {
-        const std::optional<char> result = this->func(stream);
+        std::optional<char> result = this->func(stream);
+        PARSER_PROFILE_CALL(result.has_value());
+        if (!result.has_value())
+        {
+            track_failure(stream, this->first.get());
+        }
         if (result.has_value())
         {
             if (this->void_call)
@@ -202,7 +420,7 @@ struct Parser<char>
         return result;
     }
 
-    Parser<char> &operator[](Action<void> &action)
+    Parser<char> &operator[](const Action<void> &action)
     {
         void_call = action;
         return *this;
@@ -214,7 +432,7 @@ struct Parser<char>
         return *this;
     }
 
-    Parser<char> &operator[](Action<char> &action)
+    Parser<char> &operator[](const Action<char> &action)
     {
         call = action;
         return *this;
@@ -227,66 +445,128 @@ struct Parser<char>
     }
 };
 
+// number scanners shared by Parser<int>, Parser<double> and the static parsers,
+// they never allocate and convert with std::from_chars
+
+inline std::optional<int> scan_int(std::string_view &stream)
+{
+    size_t index = 0;
+    if (!stream.empty() && (stream.front() == '+' || stream.front() == '-'))
+    {
+        ++index;
+    }
+    const size_t start = index;
+    while (index < stream.length() && '0' <= stream[index] && stream[index] <= '9')
+    {
+        ++index;
+    }
+    if (index == start)
+    {
+        return std::nullopt;
+    }
+
+    int value = 0;
+    const char *first = stream.data() + (stream.front() == '+' ? 1 : 0);
+    if (std::from_chars(first, stream.data() + index, value).ec != std::errc())
+    {
+        return std::nullopt;
+    }
+    stream.remove_prefix(index);
+    return value;
+}
+
+inline std::optional<double> scan_float(std::string_view &stream)
+{
+    if (stream.empty())
+    {
+        return std::nullopt;
+    }
+    size_t index = 0;
+    bool negative = false;
+    if (stream.front() == '+')
+    {
+        ++index;
+    }
+    else if (stream.front() == '-')
+    {
+        ++index;
+        negative = true;
+    }
+    const size_t start = index;
+    size_t point = std::string_view::npos, digits = 0;
+    uint64_t mantissa = 0;
+    while (index < stream.length() && (('0' <= stream[index] && stream[index] <= '9')
+        || (stream[index] == '.' && point == std::string_view::npos)))
+    {
+        if (stream[index] == '.')
+        {
+            point = index;
+        }
+        else if (++digits <= 19)
+        {
+            mantissa = mantissa * 10 + (stream[index] - '0');
+        }
+        ++index;
+    }
+
+    bool exponent = false;
+    if (index < stream.length() && index > start && (stream[index] == 'e' || stream[index] == 'E'))
+    {
+        size_t end = index + 1;
+        if (end < stream.length() && stream[end] == '-')
+        {
+            ++end;
+        }
+        const size_t exp_start = end;
+        while (end < stream.length() && '0' <= stream[end] && stream[end] <= '9')
+        {
+            ++end;
+        }
+        if (end > exp_start)
+        {
+            index = end;
+            exponent = true;
+        }
+        else if (index > start && stream[index - 1] == '.')
+        {
+            // "1.e" backs off to "1", the same way a dangling exponent does
+            --index;
+            point = std::string_view::npos;
+        }
+    }
+    if (digits == 0)
+    {
+        return std::nullopt;
+    }
+
+    // fixed-point fast path, exact when both the mantissa and the power of ten fit in a double
+    const size_t fraction = point == std::string_view::npos ? 0 : index - point - 1;
+    if (!exponent && digits <= 15 && fraction <= 22)
+    {
+        static constexpr double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        const double value = static_cast<double>(mantissa) / pow10[fraction];
+        stream.remove_prefix(index);
+        return negative ? -value : value;
+    }
+
+    double value = 0;
+    const char *first = stream.data() + (stream.front() == '+' ? 1 : 0);
+    if (std::from_chars(first, stream.data() + index, value).ec != std::errc())
+    {
+        return std::nullopt;
+    }
+    stream.remove_prefix(index);
+    return value;
+}
+
 template <>
 struct Parser<double>
 {
-    std::function<std::optional<double>(std::string_view &)> func = 
-        [](std::string_view &stream) -> std::optional<double>
-        {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-            size_t index = 0;
-            std::vector<char> num;
-            if (stream.front() == '+')
-            {
-                ++index;
-            }
-            else if (stream.front() == '-')
-            {
-                ++index;
-                num.emplace_back('-');
-            }
-            bool find_point = false;
-            while (index < stream.length() && (('0' <= stream[index] && stream[index] <= '9')
-                || (stream[index] == '.' && !find_point)) )
-            {
-                num.emplace_back(stream[index]);
-                if (stream[index++] == '.')
-                {
-                    find_point = true;
-                }
-            }
-            if (index < stream.length() && !num.empty() && (stream[index] == 'e' || stream[index] == 'E'))
-            {
-                num.emplace_back(stream[index++]);
-                if (index < stream.length() && stream[index] == '-')
-                {
-                    num.emplace_back(stream[index++]);
-                }
-                while (index < stream.length() && ('0' <= stream[index] && stream[index] <= '9'))
-                {
-                    num.emplace_back(stream[index++]);
-                }
-                while (!num.empty() && (num.back() < '0' || num.back() > '9'))
-                {
-                    num.pop_back();
-                    --index;
-                }
-            }
-            if (num.empty())
-            {
-                return std::nullopt;
-            }
-            else
-            {
-                stream.remove_prefix(index);
-                return std::stod(std::string(num.cbegin(), num.cend()));
-            }
-        };
+    std::function<std::optional<double>(std::string_view &)> func = scan_float;
 
     Action<double> call;
+    std::shared_ptr<const CharSet> first;
 
     Parser() {}
 
@@ -294,11 +574,16 @@ struct Parser<double>
         : func(f) {}
 
     Parser(const Parser<double> &parser)
-        : func(parser.func), call(parser.call) {}
+        : func(parser.func), call(parser.call), first(parser.first) {}
 
     std::optional<double> operator()(std::string_view &stream) const
     {
         const std::optional<double> result = this->func(stream);
+        PARSER_PROFILE_CALL(result.has_value());
+        if (!result.has_value())
+        {
+            track_failure(stream, this->first.get());
+        }
         if (result.has_value() && this->call)
         {
             this->call(result.value());
@@ -306,7 +591,7 @@ struct Parser<double>
         return result;
     }
 
-    Parser<double> &operator[](Action<double> &action)
+    Parser<double> &operator[](const Action<double> &action)
     {
         call = action;
         return *this;
@@ -322,40 +607,10 @@ struct Parser<double>
 template <>
 struct Parser<int>
 {
-    std::function<std::optional<int>(std::string_view &)> func = 
-        [](std::string_view &stream) -> std::optional<int>
-        {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-            size_t index = 0;
-            std::vector<char> num;
-            if (stream.front() == '+')
-            {
-                ++index;
-            }
-            else if (stream.front() == '-')
-            {
-                ++index;
-                num.emplace_back('-');
-            }
-            while (index < stream.length() && '0' <= stream[index] && stream[index] <= '9')
-            {
-                num.emplace_back(stream[index++]);
-            }
-            if (num.empty())
-            {
-                return std::nullopt;
-            }
-            else
-            {
-                stream.remove_prefix(index);
-                return std::stoi(std::string(num.cbegin(), num.cend()));
-            }
-        };
+    std::function<std::optional<int>(std::string_view &)> func = scan_int;
 
     Action<int> call;
+    std::shared_ptr<const CharSet> first;
 
     Parser() {}
 
@@ -363,11 +618,16 @@ struct Parser<int>
         : func(f) {}
 
     Parser(const Parser<int> &parser)
-        : func(parser.func), call(parser.call) {}
+        : func(parser.func), call(parser.call), first(parser.first) {}
 
     std::optional<int> operator()(std::string_view &stream) const
     {
         const std::optional<int> result = this->func(stream);
+        PARSER_PROFILE_CALL(result.has_value());
+        if (!result.has_value())
+        {
+            track_failure(stream, this->first.get());
+        }
         if (result.has_value() && this->call)
         {
             this->call(result.value());
@@ -375,7 +635,7 @@ struct Parser<int>
         return result;
     }
 
-    Parser<int> &operator[](Action<int> &action)
+    Parser<int> &operator[](const Action<int> &action)
     {
         call = action;
         return *this;
@@ -388,12 +648,114 @@ struct Parser<int>
     }
 };
 
+// DFA over a keyword set, see keywords_p.
+// Bytes are first mapped to columns so a state only stores the columns that occur in
+// some keyword; state 0 is the dead state, state 1 the start.
+struct KeywordTable
+{
+    unsigned char columns[256] = {};
+    size_t width = 1;
+    std::vector<uint32_t> next;
+    // id of the keyword ending in each state, -1 if none
+    std::vector<int> accept;
+
+    KeywordTable(const std::vector<std::string> &keywords)
+    {
+        for (const std::string &keyword : keywords)
+        {
+            for (const char ch : keyword)
+            {
+                unsigned char &column = columns[static_cast<unsigned char>(ch)];
+                if (column == 0)
+                {
+                    column = static_cast<unsigned char>(width++);
+                }
+            }
+        }
+        next.assign(2 * width, 0);
+        accept.assign(2, -1);
+        for (size_t id = 0; id < keywords.size(); ++id)
+        {
+            uint32_t state = 1;
+            for (const char ch : keywords[id])
+            {
+                uint32_t &target = next[state * width + columns[static_cast<unsigned char>(ch)]];
+                if (target == 0)
+                {
+                    target = static_cast<uint32_t>(accept.size());
+                    next.resize(next.size() + width, 0);
+                    accept.push_back(-1);
+                }
+                state = next[state * width + columns[static_cast<unsigned char>(ch)]];
+            }
+            if (accept[state] < 0)
+            {
+                accept[state] = static_cast<int>(id);
+            }
+        }
+    }
+
+    // id of the longest keyword at the front of stream, which is consumed
+    std::optional<int> operator()(std::string_view &stream) const
+    {
+        uint32_t state = 1;
+        int id = accept[1];
+        size_t length = 0;
+        for (size_t i = 0; i < stream.length(); ++i)
+        {
+            state = next[state * width + columns[static_cast<unsigned char>(stream[i])]];
+            if (state == 0)
+            {
+                break;
+            }
+            if (accept[state] >= 0)
+            {
+                id = accept[state];
+                length = i + 1;
+            }
+        }
+        if (id < 0)
+        {
+            return std::nullopt;
+        }
+        stream.remove_prefix(length);
+        return id;
+    }
+};
+
 
 inline Parser<std::string> str_p(const std::string &value)
 {
     return Parser<std::string>(value);
 }
 
+inline Parser<std::string_view> strv_p(const std::string_view value)
+{
+    return Parser<std::string_view>(value);
+}
+
+// matches the longest of the keywords in one pass and returns its index in the list,
+// the first of duplicate keywords wins
+inline Parser<int> keywords_p(const std::vector<std::string> &keywords)
+{
+    const std::shared_ptr<const KeywordTable> table = std::make_shared<const KeywordTable>(keywords);
+    Parser<int> parser(std::function<std::optional<int>(std::string_view &)>(
+        [=](std::string_view &stream) -> std::optional<int>
+        {
+            return (*table)(stream);
+        }));
+    if (table->accept[1] < 0)
+    {
+        CharSet first;
+        for (const std::string &keyword : keywords)
+        {
+            first.set(keyword.front(), keyword.front());
+        }
+        parser.first = std::make_shared<const CharSet>(first);
+    }
+    return parser;
+}
+
 inline Parser<char> ch_p(const char value)
 {
     return Parser<char>(value);
@@ -401,7 +763,7 @@ inline Parser<char> ch_p(const char value)
 
 inline Parser<char> anychar_p()
 {
-    return Parser<char>(std::function<std::optional<char>(std::string_view &)>(
+    Parser<char> parser(std::function<std::optional<char>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<char>
         {
             if (!stream.empty())
@@ -415,15 +777,17 @@ inline Parser<char> anychar_p()
                 return std::nullopt;
             }
         }));
+    parser.first = std::make_shared<const CharSet>(CharSet().set('\0', '\xFF'));
+    return parser;
 }
 
-inline Parser<char> alpha_p()
+inline Parser<char> charset_p(const CharSet &set)
 {
-    return Parser<char>(std::function<std::optional<char>(std::string_view &)>(
+    const std::shared_ptr<const CharSet> table = std::make_shared<const CharSet>(set);
+    Parser<char> parser(std::function<std::optional<char>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<char>
         {
-            if (!stream.empty() && (('a' <= stream.front() && stream.front() <= 'z') 
-                || ('A' <= stream.front() && stream.front() <= 'Z')))
+            if (!stream.empty() && table->test(stream.front()))
             {
                 const char ch = stream.front();
                 stream.remove_prefix(1);
@@ -434,67 +798,34 @@ inline Parser<char> alpha_p()
                 return std::nullopt;
             }
         }));
+    parser.charset = table;
+    parser.first = table;
+    return parser;
+}
+
+inline Parser<char> alpha_p()
+{
+    return charset_p(CharSet("a-zA-Z"));
 }
 
 inline Parser<char> alphaa_p()
 {
-    return Parser<char>(std::function<std::optional<char>(std::string_view &)>(
-        [=](std::string_view &stream) -> std::optional<char>
-        {
-            if (!stream.empty() && 'A' <= stream.front() && stream.front() <= 'Z')
-            {
-                const char ch = stream.front();
-                stream.remove_prefix(1);
-                return ch;
-            }
-            else
-            {
-                return std::nullopt;
-            }
-        }));
+    return charset_p(CharSet("A-Z"));
 }
 
 inline Parser<char> alphab_p()
 {
-    return Parser<char>(std::function<std::optional<char>(std::string_view &)>(
-        [=](std::string_view &stream) -> std::optional<char>
-        {
-            if (!stream.empty() && 'a' <= stream.front() && stream.front() <= 'z')
-            {
-                const char ch = stream.front();
-                stream.remove_prefix(1);
-                return ch;
-            }
-            else
-            {
-                return std::nullopt;
-            }
-        }));
+    return charset_p(CharSet("a-z"));
 }
 
 inline Parser<char> alnum_p()
 {
-    return Parser<char>(std::function<std::optional<char>(std::string_view &)>(
-        [=](std::string_view &stream) -> std::optional<char>
-        {
-            if (!stream.empty() && (('a' <= stream.front() && stream.front() <= 'z') 
-                || ('A' <= stream.front() && stream.front() <= 'Z') 
-                || ('0' <= stream.front() && stream.front() <= '9')))
-            {
-                const char ch = stream.front();
-                stream.remove_prefix(1);
-                return ch;
-            }
-            else
-            {
-                return std::nullopt;
-            }
-        }));
+    return charset_p(CharSet("a-zA-Z0-9"));
 }
 
 inline Parser<char> eol_p()
 {
-    return Parser<char>(std::function<std::optional<char>(std::string_view &)>(
+    Parser<char> parser(std::function<std::optional<char>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<char>
         {
             if (!stream.empty() && (stream.front() == 10 || stream.front() == 13))
@@ -512,21 +843,27 @@ inline Parser<char> eol_p()
                 return std::nullopt;
             }
         }));
+    parser.first = std::make_shared<const CharSet>("\n\r");
+    return parser;
 }
 
 inline Parser<double> float_p()
 {
-    return Parser<double>();
+    Parser<double> parser;
+    parser.first = std::make_shared<const CharSet>("-+.0-9");
+    return parser;
 }
 
 inline Parser<int> int_p()
 {
-    return Parser<int>();
+    Parser<int> parser;
+    parser.first = std::make_shared<const CharSet>("-+0-9");
+    return parser;
 }
 
 inline Parser<int> digit_p()
 {
-    return Parser<int>(std::function<std::optional<int>(std::string_view &)>(
+    Parser<int> parser(std::function<std::optional<int>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<int>
         {
             if (!stream.empty() && '0' <= stream.front() && stream.front() <= '9')
@@ -540,4 +877,199 @@ inline Parser<int> digit_p()
                 return std::nullopt;
             }
         }));
+    parser.first = std::make_shared<const CharSet>("0-9");
+    return parser;
+}
+
+// names a rule for the PARSER_INSTRUMENT report, returns the parser unchanged otherwise;
+// the instrumented wrapper keeps the FIRST set and the literal, class and alternation metadata,
+// so combinators take the same fast paths as in a production build
+template <typename T>
+inline Parser<T> name_p(const std::string &name, const Parser<T> &parser)
+{
+#ifdef PARSER_INSTRUMENT
+    const size_t id = Profile::next_id();
+    Parser<T> result = [&]()
+    {
+        if constexpr(std::is_same<T, bool>::value)
+        {
+            return Parser<bool>(std::function<bool(std::string_view &)>(
+                [=](std::string_view &stream) -> bool
+                {
+                    Profile &profile = Profile::current();
+                    const Profile::Scope scope(profile, profile.rule(id, name));
+                    return parser(stream);
+                }));
+        }
+        else
+        {
+            return Parser<T>(std::function<std::optional<T>(std::string_view &)>(
+                [=](std::string_view &stream) -> std::optional<T>
+                {
+                    Profile &profile = Profile::current();
+                    const Profile::Scope scope(profile, profile.rule(id, name));
+                    return parser(stream);
+                }));
+        }
+    }();
+    result.first = parser.first;
+    if constexpr(std::is_same<T, bool>::value || std::is_same<T, std::string>::value)
+    {
+        result.alternation = parser.alternation;
+    }
+    if constexpr(std::is_same<T, char>::value || std::is_same<T, std::string>::value
+        || std::is_same<T, std::string_view>::value)
+    {
+        result.literal = parser.literal;
+    }
+    if constexpr(std::is_same<T, char>::value || std::is_same<T, std::string_view>::value)
+    {
+        result.charset = parser.charset;
+    }
+    return result;
+#else
+    (void)name;
+    return parser;
+#endif
+}
+
+// Nesting of the depth_p rules running on this thread.
+// Recursion through std::ref costs several C++ frames per level, depth_p bounds it so deeply
+// nested input fails cleanly instead of overflowing the stack. A depth_p that refused to go
+// deeper sets exceeded, which stays set until the caller clears it: the enclosing rules may
+// still match a prefix, so check it after the parse to tell the two failures apart.
+struct Nesting
+{
+    size_t depth = 0;
+    bool exceeded = false;
+
+    static Nesting &current()
+    {
+        static thread_local Nesting nesting;
+        return nesting;
+    }
+
+    // one level deeper for its lifetime, also when the parser throws
+    class Level
+    {
+    private:
+        Nesting &_nesting;
+
+    public:
+        Level(Nesting &nesting)
+            : _nesting(nesting)
+        {
+            ++_nesting.depth;
+        }
+
+        Level(const Level &) = delete;
+
+        Level &operator=(const Level &) = delete;
+
+        ~Level()
+        {
+            --_nesting.depth;
+        }
+    };
+};
+
+template <typename T, typename L, typename P>
+inline Parser<T> depth_p(const L &limit, const P &parser)
+{
+    using Result = std::conditional_t<std::is_same<T, bool>::value, bool, std::optional<T>>;
+    return Parser<T>(std::function<Result(std::string_view &)>(
+        [=](std::string_view &stream) -> Result
+        {
+            Nesting &nesting = Nesting::current();
+            if (nesting.depth >= static_cast<const size_t &>(limit))
+            {
+                nesting.exceeded = true;
+                return Result();
+            }
+            const Nesting::Level level(nesting);
+            return parser(stream);
+        }));
+}
+
+// parser, failing when limit depth_p rules are already running on this thread
+template <typename T>
+inline Parser<T> depth_p(const size_t limit, const Parser<T> &parser)
+{
+    Parser<T> result = depth_p<T, size_t, Parser<T>>(limit, parser);
+    result.first = parser.first;
+    return result;
+}
+
+template <typename T>
+inline Parser<T> depth_p(const size_t limit, const std::reference_wrapper<Parser<T>> &parser)
+{
+    return depth_p<T, size_t, std::reference_wrapper<Parser<T>>>(limit, parser);
+}
+
+// the same with the limit read on every call, so it can be changed after the grammar is built
+//     depth_p(std::cref(max_nesting), std::ref(exper))
+template <typename T>
+inline Parser<T> depth_p(const std::reference_wrapper<const size_t> &limit, const Parser<T> &parser)
+{
+    Parser<T> result = depth_p<T, std::reference_wrapper<const size_t>, Parser<T>>(limit, parser);
+    result.first = parser.first;
+    return result;
+}
+
+template <typename T>
+inline Parser<T> depth_p(const std::reference_wrapper<const size_t> &limit, const std::reference_wrapper<Parser<T>> &parser)
+{
+    return depth_p<T, std::reference_wrapper<const size_t>, std::reference_wrapper<Parser<T>>>(limit, parser);
+}
+
+template <typename T, typename P>
+inline Parser<T> expect_p(const std::string &label, const P &parser)
+{
+    using Result = std::conditional_t<std::is_same<T, bool>::value, bool, std::optional<T>>;
+    const std::shared_ptr<const std::string> name = std::make_shared<const std::string>(label);
+    return Parser<T>(std::function<Result(std::string_view &)>(
+        [=](std::string_view &stream) -> Result
+        {
+            Result result = parser(stream);
+            if (!result)
+            {
+                if (Failure *failure = Context<Failure>::current())
+                {
+                    failure->fail(stream.data(), *name);
+                }
+            }
+            return result;
+        }));
+}
+
+// parser, named label in the expected list of a Failure when it fails
+template <typename T>
+inline Parser<T> expect_p(const std::string &label, const Parser<T> &parser)
+{
+    Parser<T> result = expect_p<T, Parser<T>>(label, parser);
+    result.first = parser.first;
+    return result;
+}
+
+template <typename T>
+inline Parser<T> expect_p(const std::string &label, const std::reference_wrapper<Parser<T>> &parser)
+{
+    return expect_p<T, std::reference_wrapper<Parser<T>>>(label, parser);
+}
+
+// Matches the empty string and commits to everything parsed before it: the alternation,
+// optional or repetition attempt that is running may no longer backtrack past this point,
+// so when it fails the enclosing choice points fail too, up to the top-level driver.
+// "if" >> cut_p() >> condition >> body reports a broken condition right away instead of
+// trying the remaining statement kinds on it.
+inline Parser<bool> cut_p()
+{
+    return Parser<bool>(std::function<bool(std::string_view &)>(
+        [](std::string_view &stream) -> bool
+        {
+            Cut &cut = Cut::current();
+            ++cut.passed;
+            cut.position = stream.data();
+            return true;
+        }));
 }
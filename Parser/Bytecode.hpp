@@ -0,0 +1,632 @@
+#pragma once
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BaseParser.hpp"
+
+
+// Grammars compiled to bytecode for a backtracking virtual machine, in the style of LPeg.
+// Meant for grammars assembled at run time, e.g. from configuration: patterns are plain
+// values built with the functions and operators below, the rules of a Grammar refer to each
+// other by name and Grammar::compile() links them into one Program. Running a Program is a
+// loop over a flat instruction array; pending alternatives and rule calls are entries on an
+// explicit stack instead of C++ frames, and there is no std::function call per node.
+// A Parser<T> is type-erased and cannot be walked, so grammars are described here rather
+// than compiled from ParserGen2 parsers; to_parser() plugs a Program back into them.
+// Matching follows the other generators: alternatives are ordered, repetitions are greedy
+// and never give input back.
+// Functions live in namespace Bytecode and should be called qualified, operators are found by ADL.
+
+namespace Bytecode
+{
+
+enum class Kind {CHAR, SET, STR, ANY, SEQ, ALT, MANY, OPT, NOT, RULE};
+
+struct Node
+{
+    Kind kind;
+    char ch = 0;
+    CharSet set;
+    // literal of STR, name of RULE
+    std::string text;
+    std::shared_ptr<const Node> left;
+    std::shared_ptr<const Node> right;
+};
+
+struct Pattern
+{
+    std::shared_ptr<const Node> node;
+};
+
+enum class Op : uint8_t {CHAR, SET, STR, ANY, SPAN, TEST_SET, CHOICE, COMMIT, PARTIAL_COMMIT, FAIL_TWICE, CALL, RET,
+    END};
+
+struct Instruction
+{
+    Op op;
+    char ch;
+    // jump target, or index into Program::sets or Program::strings
+    uint32_t arg;
+};
+
+// CHAR, SET, STR, ANY    match one character, a character of a set, a literal, any character
+// SPAN                   skip the characters of a set
+// TEST_SET               jump to arg unless the next character is in set ch, consumes nothing
+// CHOICE                 push an alternative resuming at arg with the current position
+// COMMIT                 drop the alternative and jump to arg
+// PARTIAL_COMMIT         loop back to arg, the alternative moves to the current position;
+//                        an iteration that consumed nothing ends the loop instead
+// FAIL_TWICE             drop the alternative and fail, for predicates
+// CALL, RET              enter a rule at arg, return behind the call
+// END                    the match succeeded
+// A failure unwinds the stack to the latest alternative, the match fails when there is none.
+// The stack lives on the heap and grows as needed, up to max_depth entries: input nested
+// deeper than that ends the match with TOO_DEEP instead of exhausting memory.
+enum class MatchStatus {MATCHED, FAILED, TOO_DEEP};
+
+struct Program
+{
+    std::vector<Instruction> code;
+    std::vector<CharSet> sets;
+    std::vector<std::string> strings;
+    // FIRST set of the start rule, null if unknown
+    std::shared_ptr<const CharSet> first;
+    // pending alternatives and rule calls at most
+    size_t max_depth = 1 << 20;
+
+    // matches at the front of stream and consumes the match
+    bool match(std::string_view &stream) const
+    {
+        return run(stream) == MatchStatus::MATCHED;
+    }
+
+    // like match, and tells a failed match from one that nested too deep
+    MatchStatus run(std::string_view &stream) const
+    {
+        struct Entry
+        {
+            const char *position;
+            uint32_t pc;
+            // a return address instead of an alternative
+            bool call;
+        };
+
+        static thread_local std::vector<Entry> entries;
+        std::vector<Entry> &stack = entries;
+        stack.clear();
+        const Instruction *const instructions = code.data();
+        const CharSet *const charsets = sets.data();
+        const char *const begin = stream.data();
+        const char *const end = begin + stream.length();
+        const char *position = begin;
+        uint32_t pc = 0;
+        for (;;)
+        {
+            const Instruction &instruction = instructions[pc];
+            switch (instruction.op)
+            {
+            case Op::CHAR:
+                if (position != end && *position == instruction.ch)
+                {
+                    ++position;
+                    ++pc;
+                    continue;
+                }
+                break;
+            case Op::SET:
+                if (position != end && charsets[instruction.arg].test(*position))
+                {
+                    ++position;
+                    ++pc;
+                    continue;
+                }
+                break;
+            case Op::STR:
+            {
+                const std::string &literal = strings[instruction.arg];
+                if (static_cast<size_t>(end - position) >= literal.length()
+                    && std::memcmp(position, literal.data(), literal.length()) == 0)
+                {
+                    position += literal.length();
+                    ++pc;
+                    continue;
+                }
+                break;
+            }
+            case Op::ANY:
+                if (position != end)
+                {
+                    ++position;
+                    ++pc;
+                    continue;
+                }
+                break;
+            case Op::SPAN:
+            {
+                const CharSet &set = charsets[instruction.arg];
+                while (position != end && set.test(*position))
+                {
+                    ++position;
+                }
+                ++pc;
+                continue;
+            }
+            case Op::TEST_SET:
+                pc = position != end && charsets[static_cast<unsigned char>(instruction.ch)].test(*position)
+                    ? pc + 1 : instruction.arg;
+                continue;
+            case Op::CHOICE:
+                if (stack.size() == max_depth)
+                {
+                    return MatchStatus::TOO_DEEP;
+                }
+                stack.push_back(Entry{position, instruction.arg, false});
+                ++pc;
+                continue;
+            case Op::COMMIT:
+                stack.pop_back();
+                pc = instruction.arg;
+                continue;
+            case Op::PARTIAL_COMMIT:
+                if (stack.back().position == position)
+                {
+                    stack.pop_back();
+                    ++pc;
+                }
+                else
+                {
+                    stack.back().position = position;
+                    pc = instruction.arg;
+                }
+                continue;
+            case Op::FAIL_TWICE:
+                stack.pop_back();
+                break;
+            case Op::CALL:
+                if (stack.size() == max_depth)
+                {
+                    return MatchStatus::TOO_DEEP;
+                }
+                stack.push_back(Entry{nullptr, pc + 1, true});
+                pc = instruction.arg;
+                continue;
+            case Op::RET:
+                pc = stack.back().pc;
+                stack.pop_back();
+                continue;
+            case Op::END:
+                stream.remove_prefix(static_cast<size_t>(position - begin));
+                return MatchStatus::MATCHED;
+            }
+
+            // failure, resume at the latest alternative
+            while (!stack.empty() && stack.back().call)
+            {
+                stack.pop_back();
+            }
+            if (stack.empty())
+            {
+                return MatchStatus::FAILED;
+            }
+            pc = stack.back().pc;
+            position = stack.back().position;
+            stack.pop_back();
+        }
+    }
+};
+
+namespace detail
+{
+
+inline Pattern make(const Kind kind, const Pattern &left = Pattern(), const Pattern &right = Pattern())
+{
+    Node node;
+    node.kind = kind;
+    node.left = left.node;
+    node.right = right.node;
+    return Pattern{std::make_shared<const Node>(node)};
+}
+
+// characters a match must start with, nullopt when unknown or the pattern may match nothing
+inline std::optional<CharSet> first_of(const Node &node)
+{
+    switch (node.kind)
+    {
+    case Kind::CHAR:
+        return CharSet().set(node.ch, node.ch);
+    case Kind::SET:
+        return node.set;
+    case Kind::STR:
+        if (node.text.empty())
+        {
+            return std::nullopt;
+        }
+        return CharSet().set(node.text.front(), node.text.front());
+    case Kind::ANY:
+        return CharSet().set('\0', '\xFF');
+    case Kind::SEQ:
+        return first_of(*node.left);
+    case Kind::ALT:
+    {
+        const std::optional<CharSet> left = first_of(*node.left);
+        const std::optional<CharSet> right = first_of(*node.right);
+        if (!left.has_value() || !right.has_value())
+        {
+            return std::nullopt;
+        }
+        return left.value() | right.value();
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+class Compiler
+{
+private:
+    Program _program;
+    // rules in the order they are first called, and the CALL instructions of each
+    std::vector<std::string> _rules;
+    std::vector<std::vector<uint32_t>> _calls;
+
+    uint32_t here() const
+    {
+        return static_cast<uint32_t>(_program.code.size());
+    }
+
+    uint32_t emit(const Op op, const char ch = 0, const uint32_t arg = 0)
+    {
+        _program.code.push_back(Instruction{op, ch, arg});
+        return here() - 1;
+    }
+
+    uint32_t add_set(const CharSet &set)
+    {
+        _program.sets.push_back(set);
+        return static_cast<uint32_t>(_program.sets.size() - 1);
+    }
+
+    void call(const std::string &name)
+    {
+        size_t rule = 0;
+        while (rule < _rules.size() && _rules[rule] != name)
+        {
+            ++rule;
+        }
+        if (rule == _rules.size())
+        {
+            _rules.push_back(name);
+            _calls.emplace_back();
+        }
+        _calls[rule].push_back(emit(Op::CALL));
+    }
+
+    void compile(const Node &node)
+    {
+        switch (node.kind)
+        {
+        case Kind::CHAR:
+            emit(Op::CHAR, node.ch);
+            break;
+        case Kind::SET:
+            emit(Op::SET, 0, add_set(node.set));
+            break;
+        case Kind::STR:
+            if (node.text.length() == 1)
+            {
+                emit(Op::CHAR, node.text.front());
+            }
+            else if (!node.text.empty())
+            {
+                _program.strings.push_back(node.text);
+                emit(Op::STR, 0, static_cast<uint32_t>(_program.strings.size() - 1));
+            }
+            break;
+        case Kind::ANY:
+            emit(Op::ANY);
+            break;
+        case Kind::SEQ:
+            compile(*node.left);
+            compile(*node.right);
+            break;
+        case Kind::ALT:
+        {
+            // the left branch is skipped without pushing an alternative when it cannot start here
+            const std::optional<CharSet> first = first_of(*node.left);
+            const bool test = first.has_value() && _program.sets.size() < 256;
+            const uint32_t skip = test ? emit(Op::TEST_SET, static_cast<char>(add_set(first.value()))) : 0;
+            const uint32_t choice = emit(Op::CHOICE);
+            compile(*node.left);
+            const uint32_t commit = emit(Op::COMMIT);
+            _program.code[choice].arg = here();
+            if (test)
+            {
+                _program.code[skip].arg = here();
+            }
+            compile(*node.right);
+            _program.code[commit].arg = here();
+            break;
+        }
+        case Kind::MANY:
+            if (node.left->kind == Kind::CHAR || node.left->kind == Kind::SET)
+            {
+                emit(Op::SPAN, 0, add_set(first_of(*node.left).value()));
+            }
+            else if (const std::optional<CharSet> first = first_of(*node.left); first.has_value()
+                && _program.sets.size() < 256)
+            {
+                // a body with a known FIRST set always consumes, a failed test ends the loop
+                // before an alternative is pushed
+                const uint32_t test = emit(Op::TEST_SET, static_cast<char>(add_set(first.value())));
+                const uint32_t choice = emit(Op::CHOICE);
+                compile(*node.left);
+                emit(Op::COMMIT, 0, test);
+                _program.code[test].arg = here();
+                _program.code[choice].arg = here();
+            }
+            else
+            {
+                const uint32_t choice = emit(Op::CHOICE);
+                compile(*node.left);
+                emit(Op::PARTIAL_COMMIT, 0, choice + 1);
+                _program.code[choice].arg = here();
+            }
+            break;
+        case Kind::OPT:
+            if ((node.left->kind == Kind::CHAR || node.left->kind == Kind::SET) && _program.sets.size() < 256)
+            {
+                // a single character needs no alternative, only a test
+                const uint32_t test = emit(Op::TEST_SET, static_cast<char>(add_set(first_of(*node.left).value())));
+                compile(*node.left);
+                _program.code[test].arg = here();
+            }
+            else
+            {
+                const uint32_t choice = emit(Op::CHOICE);
+                compile(*node.left);
+                emit(Op::COMMIT, 0, here() + 1);
+                _program.code[choice].arg = here();
+            }
+            break;
+        case Kind::NOT:
+        {
+            const uint32_t choice = emit(Op::CHOICE);
+            compile(*node.left);
+            emit(Op::FAIL_TWICE);
+            _program.code[choice].arg = here();
+            break;
+        }
+        case Kind::RULE:
+            call(node.text);
+            break;
+        }
+    }
+
+public:
+    // nullopt when start or a rule called from it is not defined
+    std::optional<Program> link(const std::vector<std::pair<std::string, Pattern>> &rules, const std::string &start)
+    {
+        call(start);
+        emit(Op::END);
+        std::vector<uint32_t> addresses;
+        for (size_t rule = 0; rule < _rules.size(); ++rule)
+        {
+            size_t index = 0;
+            while (index < rules.size() && rules[index].first != _rules[rule])
+            {
+                ++index;
+            }
+            if (index == rules.size())
+            {
+                return std::nullopt;
+            }
+            if (rule == 0)
+            {
+                const std::optional<CharSet> first = first_of(*rules[index].second.node);
+                _program.first = first.has_value() ? std::make_shared<const CharSet>(first.value()) : nullptr;
+            }
+            addresses.push_back(here());
+            compile(*rules[index].second.node);
+            emit(Op::RET);
+        }
+        for (size_t rule = 0; rule < _rules.size(); ++rule)
+        {
+            for (const uint32_t instruction : _calls[rule])
+            {
+                _program.code[instruction].arg = addresses[rule];
+            }
+        }
+        return _program;
+    }
+};
+
+};
+
+// named rules that may refer to each other, including recursively, through rule_p
+class Grammar
+{
+private:
+    std::vector<std::pair<std::string, Pattern>> _rules;
+
+public:
+    // defines a rule or replaces its definition
+    void define(const std::string &name, const Pattern &body)
+    {
+        for (std::pair<std::string, Pattern> &rule : _rules)
+        {
+            if (rule.first == name)
+            {
+                rule.second = body;
+                return;
+            }
+        }
+        _rules.emplace_back(name, body);
+    }
+
+    // program matching rule start, nullopt if it calls an undefined rule
+    std::optional<Program> compile(const std::string &start) const
+    {
+        return detail::Compiler().link(_rules, start);
+    }
+};
+
+// primitives
+
+inline Pattern ch_p(const char value)
+{
+    Node node;
+    node.kind = Kind::CHAR;
+    node.ch = value;
+    return Pattern{std::make_shared<const Node>(node)};
+}
+
+inline Pattern charset_p(const CharSet &set)
+{
+    Node node;
+    node.kind = Kind::SET;
+    node.set = set;
+    return Pattern{std::make_shared<const Node>(node)};
+}
+
+inline Pattern str_p(const std::string &value)
+{
+    Node node;
+    node.kind = Kind::STR;
+    node.text = value;
+    return Pattern{std::make_shared<const Node>(node)};
+}
+
+inline Pattern anychar_p()
+{
+    return detail::make(Kind::ANY);
+}
+
+inline Pattern range_p(const char lower, const char upper)
+{
+    return Bytecode::charset_p(CharSet().set(lower, upper));
+}
+
+inline Pattern alpha_p()
+{
+    return Bytecode::charset_p(CharSet("a-zA-Z"));
+}
+
+inline Pattern digit_p()
+{
+    return Bytecode::charset_p(CharSet("0-9"));
+}
+
+inline Pattern alnum_p()
+{
+    return Bytecode::charset_p(CharSet("a-zA-Z0-9"));
+}
+
+// succeeds where pattern does not match, consumes nothing
+inline Pattern not_p(const Pattern &pattern)
+{
+    return detail::make(Kind::NOT, pattern);
+}
+
+// call of a Grammar rule, resolved by Grammar::compile
+inline Pattern rule_p(const std::string &name)
+{
+    Node node;
+    node.kind = Kind::RULE;
+    node.text = name;
+    return Pattern{std::make_shared<const Node>(node)};
+}
+
+// operators
+
+inline Pattern operator>>(const Pattern &left, const Pattern &right)
+{
+    return detail::make(Kind::SEQ, left, right);
+}
+
+inline Pattern operator>>(const Pattern &left, const char right)
+{
+    return left >> ch_p(right);
+}
+
+inline Pattern operator|(const Pattern &left, const Pattern &right)
+{
+    return detail::make(Kind::ALT, left, right);
+}
+
+inline Pattern operator|(const Pattern &left, const char right)
+{
+    return left | ch_p(right);
+}
+
+inline Pattern operator*(const Pattern &pattern)
+{
+    return detail::make(Kind::MANY, pattern);
+}
+
+inline Pattern operator+(const Pattern &pattern)
+{
+    return pattern >> *pattern;
+}
+
+// optional, as in StaticParser
+inline Pattern operator!(const Pattern &pattern)
+{
+    return detail::make(Kind::OPT, pattern);
+}
+
+// one or more characters up to the first match of pattern, which is consumed as well,
+// or up to the end of the input, like operator~ of ParserGen2
+inline Pattern operator~(const Pattern &pattern)
+{
+    return +(not_p(pattern) >> anychar_p()) >> !pattern;
+}
+
+inline Pattern eol_p()
+{
+    return str_p("\r\n") | ch_p('\n') | ch_p('\r');
+}
+
+// the syntax of ::int_p(), without its range check
+inline Pattern int_p()
+{
+    return !Bytecode::charset_p(CharSet("-+")) >> +digit_p();
+}
+
+// Parser<bool>, or Parser<std::string> returning the matched text
+template <typename T = bool>
+inline Parser<T> to_parser(const Program &program)
+{
+    static_assert(std::is_same<T, bool>::value || std::is_same<T, std::string>::value,
+        "a Program converts to Parser<bool> or Parser<std::string>");
+    const std::shared_ptr<const Program> shared = std::make_shared<const Program>(program);
+    if constexpr(std::is_same<T, bool>::value)
+    {
+        Parser<bool> parser(std::function<bool(std::string_view &)>(
+            [=](std::string_view &stream) -> bool
+            {
+                return shared->match(stream);
+            }));
+        parser.first = shared->first;
+        return parser;
+    }
+    else
+    {
+        Parser<std::string> parser(std::function<std::optional<std::string>(std::string_view &)>(
+            [=](std::string_view &stream) -> std::optional<std::string>
+            {
+                std::string_view stream_copy(stream);
+                if (!shared->match(stream_copy))
+                {
+                    return std::nullopt;
+                }
+                std::string result(stream.substr(0, stream.length() - stream_copy.length()));
+                stream = stream_copy;
+                return result;
+            }));
+        parser.first = shared->first;
+        return parser;
+    }
+}
+
+};
@@ -0,0 +1,193 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include "BaseParser.hpp"
+
+
+// Operator-precedence expressions in a single pass.
+// expression_p(atom, operators) matches atom (operator atom)* and groups the operands by a
+// table of binary operators instead of one rule per precedence level. Operators wait on a
+// stack and are applied as soon as one of lower precedence (or of the same precedence, when
+// it is left associative) follows, so an atom costs one call whatever the number of levels.
+// Nesting such as parentheses belongs to the atom, which may refer back to the expression
+// through std::ref.
+// For Parser<T> every operator combines the values of its operands. For Parser<bool> it has
+// an Action<void> instead; the actions of atoms and operators run in postfix order
+// ("1 + 2 * 3" runs 1 2 3 * +), so a value stack is all an evaluator needs.
+// An operator that is not followed by an atom is left in the input, unless a cut was passed
+// in the operator or the atom after it: then the whole expression fails, see cut_p.
+
+enum class Associativity {LEFT, RIGHT};
+
+template <typename T>
+struct InfixOperator
+{
+    using Apply = std::conditional_t<std::is_same<T, bool>::value, Action<void>, std::function<T(T, T)>>;
+
+    Parser<bool> symbol;
+    // binds tighter the higher it is
+    int precedence;
+    Associativity associativity;
+    Apply apply;
+};
+
+namespace detail
+{
+
+// operands and pending operators of the expressions being parsed on this thread, nested
+// expressions work above the entries of the enclosing ones, so the storage is reused
+template <typename T>
+struct ExpressionStack
+{
+    std::vector<const InfixOperator<T> *> operators;
+    std::vector<T> values;
+
+    static ExpressionStack<T> &current()
+    {
+        static thread_local ExpressionStack<T> stack;
+        return stack;
+    }
+};
+
+template <typename T, typename P>
+Parser<T> expression_p(const P &atom, const std::vector<InfixOperator<T>> &operators)
+{
+    using Result = std::conditional_t<std::is_same<T, bool>::value, bool, std::optional<T>>;
+    return Parser<T>(std::function<Result(std::string_view &)>(
+        [=](std::string_view &stream) -> Result
+        {
+            ExpressionStack<T> &stack = ExpressionStack<T>::current();
+            const size_t base = stack.operators.size();
+            const size_t values_base = stack.values.size();
+            const Cut &cut = Cut::current();
+
+            const auto operand = [&](std::string_view &input)
+            {
+                if constexpr(std::is_same<T, bool>::value)
+                {
+                    return atom(input);
+                }
+                else
+                {
+                    std::optional<T> value = atom(input);
+                    if (!value.has_value())
+                    {
+                        return false;
+                    }
+                    stack.values.push_back(std::move(value.value()));
+                    return true;
+                }
+            };
+
+            const auto reduce = [&]()
+            {
+                const InfixOperator<T> &top = *stack.operators.back();
+                stack.operators.pop_back();
+                if constexpr(std::is_same<T, bool>::value)
+                {
+                    if (top.apply)
+                    {
+                        top.apply();
+                    }
+                }
+                else
+                {
+                    T right = std::move(stack.values.back());
+                    stack.values.pop_back();
+                    stack.values.back() = top.apply(std::move(stack.values.back()), std::move(right));
+                }
+            };
+
+            // failure past a cut, the entries of this expression are dropped unapplied
+            const auto abandon = [&]()
+            {
+                stack.operators.resize(base);
+                stack.values.erase(stack.values.begin() + values_base, stack.values.end());
+                return Result();
+            };
+
+            std::string_view stream_copy(stream);
+            if (!operand(stream_copy))
+            {
+                return Result();
+            }
+            for (;;)
+            {
+                const size_t passed = cut.passed;
+                std::string_view next(stream_copy);
+                const InfixOperator<T> *found = nullptr;
+                for (const InfixOperator<T> &candidate : operators)
+                {
+                    if (candidate.symbol.first != nullptr && (next.empty() || !candidate.symbol.first->test(next.front())))
+                    {
+                        continue;
+                    }
+                    std::string_view symbol(next);
+                    if (candidate.symbol(symbol))
+                    {
+                        next = symbol;
+                        found = &candidate;
+                        break;
+                    }
+                    if (cut.passed != passed)
+                    {
+                        return abandon();
+                    }
+                }
+                if (found == nullptr)
+                {
+                    break;
+                }
+                // the operators before this one are complete whether or not an atom follows
+                while (stack.operators.size() > base && (stack.operators.back()->precedence > found->precedence
+                    || (stack.operators.back()->precedence == found->precedence
+                    && found->associativity == Associativity::LEFT)))
+                {
+                    reduce();
+                }
+                if (!operand(next))
+                {
+                    if (cut.passed != passed)
+                    {
+                        return abandon();
+                    }
+                    break;
+                }
+                stack.operators.push_back(found);
+                stream_copy = next;
+            }
+            while (stack.operators.size() > base)
+            {
+                reduce();
+            }
+
+            stream.remove_prefix(stream.length() - stream_copy.length());
+            if constexpr(std::is_same<T, bool>::value)
+            {
+                return true;
+            }
+            else
+            {
+                T result = std::move(stack.values.back());
+                stack.values.pop_back();
+                return result;
+            }
+        }));
+}
+
+};
+
+template <typename T>
+inline Parser<T> expression_p(const Parser<T> &atom, const std::vector<InfixOperator<T>> &operators)
+{
+    Parser<T> parser = detail::expression_p<T>(atom, operators);
+    parser.first = atom.first;
+    return parser;
+}
+
+template <typename T>
+inline Parser<T> expression_p(const std::reference_wrapper<Parser<T>> &atom,
+    const std::vector<InfixOperator<T>> &operators)
+{
+    return detail::expression_p<T>(atom, operators);
+}
@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Action.hpp"
+#include "Scan.hpp"
+
+
+// Furthest-failure tracking for error messages.
+// Install a Failure for a parse with Context<Failure>::Scope. From then on every parser that
+// fails reports the position it was called at; the Failure keeps the furthest one, together
+// with the FIRST sets of the parsers that failed there and the labels of the expect_p rules
+// among them. Nothing else happens on success, and a failure short of the furthest position
+// costs one pointer compare, so the tracker can stay installed in production.
+// Line and column are only computed by locate() and describe(), from the buffer that was
+// parsed. Use one Failure per buffer: positions of different buffers cannot be compared.
+// Labels point into the grammar and are valid as long as it is.
+
+struct Failure
+{
+    struct Location
+    {
+        // both start at 1
+        size_t line = 1;
+        size_t column = 1;
+    };
+
+    static constexpr size_t max_labels = 16;
+
+    // furthest position at which a parser failed, null while nothing failed
+    const char *position = nullptr;
+    // characters the parsers failing at position would have started with
+    CharSet expected;
+    std::vector<std::string_view> labels;
+
+    bool failed() const
+    {
+        return position != nullptr;
+    }
+
+    void fail(const char *at, const CharSet *first)
+    {
+        if (position != nullptr && at < position)
+        {
+            return;
+        }
+        if (at != position)
+        {
+            position = at;
+            expected = CharSet();
+            labels.clear();
+        }
+        if (first != nullptr)
+        {
+            for (size_t i = 0; i < 4; ++i)
+            {
+                expected.bits[i] |= first->bits[i];
+            }
+        }
+    }
+
+    void fail(const char *at, const std::string_view label)
+    {
+        fail(at, nullptr);
+        if (at == position && labels.size() < max_labels
+            && std::find(labels.begin(), labels.end(), label) == labels.end())
+        {
+            labels.push_back(label);
+        }
+    }
+
+    void reset()
+    {
+        position = nullptr;
+        expected = CharSet();
+        labels.clear();
+    }
+
+    // offset of the failure in input, the buffer that was parsed
+    size_t offset(const std::string_view input) const
+    {
+        return failed() ? static_cast<size_t>(position - input.data()) : 0;
+    }
+
+    Location locate(const std::string_view input) const
+    {
+        const std::string_view before = input.substr(0, offset(input));
+        Location location;
+        location.line += static_cast<size_t>(std::count(before.begin(), before.end(), '\n'));
+        const size_t line_start = before.rfind('\n');
+        location.column += line_start == std::string_view::npos ? before.length() : before.length() - line_start - 1;
+        return location;
+    }
+
+    // "line 3, column 7: expected '+', '0'-'9' or number, found 'x'", or "...: unexpected 'x'" when
+    // nothing is known about what should have been there
+    std::string describe(const std::string_view input) const
+    {
+        const auto quote = [](const unsigned char ch)
+        {
+            const char *const escapes = "\n\\n\r\\r\t\\t";
+            for (size_t i = 0; escapes[i] != '\0'; i += 3)
+            {
+                if (static_cast<char>(ch) == escapes[i])
+                {
+                    return std::string("'") + escapes[i + 1] + escapes[i + 2] + "'";
+                }
+            }
+            if (ch < 32 || ch > 126)
+            {
+                const char *const hex = "0123456789abcdef";
+                return std::string("'\\x") + hex[ch >> 4] + hex[ch & 15] + "'";
+            }
+            return std::string("'") + static_cast<char>(ch) + "'";
+        };
+
+        std::vector<std::string> items;
+        for (unsigned int ch = 0; ch < 256; ++ch)
+        {
+            if (!expected.test(static_cast<char>(ch)))
+            {
+                continue;
+            }
+            unsigned int last = ch;
+            while (last + 1 < 256 && expected.test(static_cast<char>(last + 1)))
+            {
+                ++last;
+            }
+            if (last - ch < 2)
+            {
+                for (; ch <= last; ++ch)
+                {
+                    items.push_back(quote(ch));
+                }
+            }
+            else
+            {
+                items.push_back(quote(ch) + "-" + quote(last));
+            }
+            ch = last;
+        }
+        items.insert(items.end(), labels.begin(), labels.end());
+
+        const Location location = locate(input);
+        std::string result = "line " + std::to_string(location.line) + ", column " + std::to_string(location.column)
+            + ": ";
+        const size_t at = offset(input);
+        const std::string found = at < input.length() ? quote(static_cast<unsigned char>(input[at])) : "end of input";
+        if (items.empty())
+        {
+            return result + "unexpected " + found;
+        }
+        result += "expected ";
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            result += i == 0 ? "" : (i + 1 == items.size() ? " or " : ", ");
+            result += items[i];
+        }
+        return result + ", found " + found;
+    }
+};
+
+// called by every parser that fails, at the position it was called at
+inline void track_failure(const std::string_view &stream, const CharSet *first)
+{
+    if (Failure *failure = Context<Failure>::current())
+    {
+        failure->fail(stream.data(), first);
+    }
+}
+
+// records nothing on this thread until the scope ends; for parsers that are only probed
+// while scanning ahead, whose failures say nothing about what the input should hold
+class FailureMute
+{
+private:
+    Failure *_failure;
+
+public:
+    FailureMute()
+        : _failure(Context<Failure>::current())
+    {
+        Context<Failure>::current() = nullptr;
+    }
+
+    FailureMute(const FailureMute &) = delete;
+
+    FailureMute &operator=(const FailureMute &) = delete;
+
+    ~FailureMute()
+    {
+        Context<Failure>::current() = _failure;
+    }
+};
+
+// Records skipped by recover_p.
+// Install a Recovery for a parse with Context<Recovery>::Scope; recover_p only skips what it
+// can log here, without one a failing record fails as usual. Entries point into the buffer
+// that was parsed, the offset of one is text.data() - input.data().
+struct Recovery
+{
+    struct Skipped
+    {
+        // the failed record up to and including the sync point after it
+        std::string_view text;
+        // the furthest failure inside the record when a Failure is installed as well,
+        // describe(input) it like the Failure of a whole parse
+        Failure failure;
+    };
+
+    // once this many records were skipped, the next failing record fails the parse
+    size_t limit = std::numeric_limits<size_t>::max();
+    std::vector<Skipped> skipped;
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define PARSER_HAS_MMAP 1
+#endif
+
+
+// Read-only input for top-level parsers.
+// Regular files are memory-mapped and advised for sequential access, so the parser
+// gets a std::string_view over the page cache without copying the file.
+// Pipes, character devices and platforms without mmap fall back to one buffered read.
+
+class FileSource
+{
+private:
+    const char *_data = nullptr;
+    size_t _size = 0;
+    bool _mapped = false;
+    bool _open = false;
+    std::string _buffer;
+
+public:
+    FileSource(const std::string &path)
+    {
+#ifdef PARSER_HAS_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+        struct stat status;
+        if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0)
+        {
+            void *data = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                ::madvise(data, status.st_size, MADV_SEQUENTIAL);
+                _data = static_cast<const char *>(data);
+                _size = status.st_size;
+                _mapped = _open = true;
+                ::close(fd);
+                return;
+            }
+        }
+        char chunk[1 << 16];
+        ssize_t count = 0;
+        for (;;)
+        {
+            count = ::read(fd, chunk, sizeof(chunk));
+            if (count > 0)
+            {
+                _buffer.append(chunk, count);
+            }
+            // a signal interrupted the read, nothing was lost
+            else if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            else
+            {
+                break;
+            }
+        }
+        ::close(fd);
+        // a read error fails the open rather than passing on a truncated input
+        if (count < 0)
+        {
+            _buffer.clear();
+            return;
+        }
+        _open = true;
+#else
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return;
+        }
+        _buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        _open = true;
+#endif
+        _data = _buffer.data();
+        _size = _buffer.size();
+    }
+
+    FileSource(const FileSource &) = delete;
+
+    FileSource &operator=(const FileSource &) = delete;
+
+    ~FileSource()
+    {
+#ifdef PARSER_HAS_MMAP
+        if (_mapped)
+        {
+            ::munmap(const_cast<char *>(_data), _size);
+        }
+#endif
+    }
+
+    bool is_open() const
+    {
+        return _open;
+    }
+
+    bool is_mapped() const
+    {
+        return _mapped;
+    }
+
+    std::string_view view() const
+    {
+        return std::string_view(_data, _size);
+    }
+};
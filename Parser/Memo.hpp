@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include "BaseParser.hpp"
+
+
+// Opt-in packrat memoization.
+// Memo::operator() wraps a rule so its outcome at an input position is computed once;
+// a failed alternative or a re-parse of the same span is answered from the cache.
+// Each wrapped rule owns a direct-mapped table of a fixed number of entries, allocated
+// once, so memory stays bounded: a collision simply evicts the older entry.
+// The cache is scoped to a parse: install a Memo::Session over the buffer for the parse, and
+// positions are its offsets in that buffer. Results of an earlier session are never returned,
+// so a buffer that is reused, or freed and allocated again at the same address, cannot hit
+// stale entries. Without a session a memoized rule simply runs its rule. A cache hit returns
+// the stored result without running the rule again, so the actions inside a memoized rule
+// do not fire a second time; memoize rules that return values or have no side effects.
+
+class Memo
+{
+public:
+    // one parse of one buffer for the memoized rules, installed for the calling thread
+    // until the session ends
+    //     const Memo::Session session(input);
+    //     grammar(stream);
+    class Session
+    {
+    private:
+        const char *_base;
+        size_t _id;
+        Context<Session>::Scope _scope;
+
+        static size_t next_id()
+        {
+            static std::atomic<size_t> ids(1);
+            return ids++;
+        }
+
+    public:
+        explicit Session(const std::string_view input)
+            : _base(input.data()), _id(next_id()), _scope(*this) {}
+
+        Session(const Session &) = delete;
+
+        Session &operator=(const Session &) = delete;
+
+        // unique for every session of the program, never 0
+        size_t id() const
+        {
+            return _id;
+        }
+
+        size_t offset(const std::string_view &stream) const
+        {
+            return static_cast<size_t>(stream.data() - _base);
+        }
+    };
+
+private:
+    template <typename T>
+    struct Entry
+    {
+        size_t session = 0;
+        size_t generation = 0;
+        size_t offset = 0;
+        size_t length = 0;
+        size_t consumed = 0;
+        std::optional<T> value;
+
+        bool holds(const Session &current, const size_t gen, const size_t at, const std::string_view &stream) const
+        {
+            return session == current.id() && generation == gen && offset == at && length == stream.length();
+        }
+    };
+
+    template <typename T>
+    struct Table
+    {
+        std::vector<Entry<T>> entries;
+        std::shared_ptr<const size_t> generation;
+
+        Table(const size_t capacity, const std::shared_ptr<const size_t> &gen)
+            : entries(capacity), generation(gen) {}
+
+        Entry<T> &find(const size_t offset, const size_t length)
+        {
+            const size_t key = offset * 31 + length;
+            return entries[(key ^ (key >> 17)) % entries.size()];
+        }
+    };
+
+    std::shared_ptr<size_t> _generation;
+    size_t _capacity;
+
+    template <typename T, typename P>
+    Parser<T> wrap(const P &rule) const
+    {
+        using Value = std::conditional_t<std::is_same<T, bool>::value, bool, T>;
+        using Result = std::conditional_t<std::is_same<T, bool>::value, bool, std::optional<T>>;
+        std::shared_ptr<Table<Value>> table = std::make_shared<Table<Value>>(_capacity, _generation);
+        return Parser<T>(std::function<Result(std::string_view &)>(
+            [=](std::string_view &stream) -> Result
+            {
+                const Session *session = Context<Session>::current();
+                if (session == nullptr)
+                {
+                    return rule(stream);
+                }
+                const size_t offset = session->offset(stream);
+                const Entry<Value> &entry = table->find(offset, stream.length());
+                if (entry.holds(*session, *table->generation, offset, stream))
+                {
+                    stream.remove_prefix(entry.consumed);
+                    if constexpr(std::is_same<T, bool>::value)
+                    {
+                        return entry.value.value();
+                    }
+                    else
+                    {
+                        return entry.value;
+                    }
+                }
+                const std::string_view start(stream);
+                Result result = rule(stream);
+                Entry<Value> &slot = table->find(offset, start.length());
+                slot = Entry<Value>{session->id(), *table->generation, offset, start.length(),
+                    start.length() - stream.length(), result};
+                return result;
+            }));
+    }
+
+public:
+    // capacity is the number of cached positions per memoized rule
+    Memo(const size_t capacity = 1 << 12)
+        : _generation(std::make_shared<size_t>(1)), _capacity(capacity > 0 ? capacity : 1) {}
+
+    // forgets every cached result, also those of the running session, O(1)
+    void clear()
+    {
+        ++*_generation;
+    }
+
+    template <typename T>
+    Parser<T> operator()(const Parser<T> &rule) const
+    {
+        return wrap<T>(rule);
+    }
+
+    template <typename T>
+    Parser<T> operator()(const std::reference_wrapper<Parser<T>> &rule) const
+    {
+        return wrap<T>(rule);
+    }
+};
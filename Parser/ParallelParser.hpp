@@ -0,0 +1,134 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include "BaseParser.hpp"
+
+
+// Parallel driver for the top-level repetition of a record grammar over a complete buffer,
+// i.e. *record where every record ends with the same delimiter byte (';', '\n' of eol_p() ...).
+// The buffer is cut right after a delimiter into more chunks than threads; the workers claim
+// chunks through an atomic counter, so a slow chunk never holds up an idle thread.
+// The result is the same as parsing the buffer front to back: values come in input order and
+// everything past the first failing record is discarded.
+//
+// Parser copies share their actions, so actions must not write to shared objects.
+// Each chunk gets its own S, installed as the Context<S> of the thread parsing it, and
+// actions bound with Action(&S::member) or reading Context<S>::current() write there;
+// the sinks are returned in input order for the caller to merge.
+// Memo wrapped rules keep a shared cache and must not be used here.
+
+// default sink for grammars whose actions keep no state
+struct NoSink {};
+
+template <typename T, typename S>
+struct ParallelResult
+{
+    // record values in input order, empty for Parser<bool>
+    std::vector<T> values;
+    // one sink per chunk in input order
+    std::vector<S> sinks;
+    size_t count = 0;
+    // offset of the first record that failed to parse
+    std::optional<size_t> error;
+};
+
+template <typename S = NoSink, typename T>
+ParallelResult<T, S> parallel_parse(const Parser<T> &record, const std::string_view input, const char delimiter,
+    size_t threads = std::thread::hardware_concurrency())
+{
+    struct Chunk
+    {
+        size_t begin = 0;
+        size_t end = 0;
+        ParallelResult<T, S> result;
+    };
+
+    threads = threads == 0 ? 1 : threads;
+    // below this a chunk is not worth a thread
+    constexpr size_t min_chunk = 1 << 16;
+    const size_t target = std::max(min_chunk, input.length() / (threads * 8) + 1);
+
+    std::vector<Chunk> chunks;
+    for (size_t begin = 0; begin < input.length();)
+    {
+        size_t end = begin + target;
+        if (end >= input.length())
+        {
+            end = input.length();
+        }
+        else
+        {
+            const void *found = std::memchr(input.data() + end, delimiter, input.length() - end);
+            end = found == nullptr ? input.length() : static_cast<const char *>(found) - input.data() + 1;
+        }
+        chunks.emplace_back();
+        chunks.back().begin = begin;
+        chunks.back().end = end;
+        begin = end;
+    }
+
+    const auto parse = [&](Chunk &chunk)
+    {
+        const typename Context<S>::Scope scope(chunk.result.sinks.emplace_back());
+        std::string_view stream = input.substr(chunk.begin, chunk.end - chunk.begin);
+        while (!stream.empty())
+        {
+            const size_t length = stream.length();
+            if constexpr(std::is_same<T, bool>::value)
+            {
+                if (!record(stream) || stream.length() == length)
+                {
+                    chunk.result.error = chunk.end - length;
+                    break;
+                }
+            }
+            else
+            {
+                std::optional<T> value = record(stream);
+                if (!value.has_value() || stream.length() == length)
+                {
+                    chunk.result.error = chunk.end - length;
+                    break;
+                }
+                chunk.result.values.push_back(std::move(value.value()));
+            }
+            ++chunk.result.count;
+        }
+    };
+
+    std::atomic<size_t> next(0);
+    const auto work = [&]()
+    {
+        for (size_t i = next.fetch_add(1); i < chunks.size(); i = next.fetch_add(1))
+        {
+            parse(chunks[i]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min(threads, chunks.size()); ++i)
+    {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    ParallelResult<T, S> result;
+    for (Chunk &chunk : chunks)
+    {
+        result.values.insert(result.values.end(), std::make_move_iterator(chunk.result.values.begin()),
+            std::make_move_iterator(chunk.result.values.end()));
+        result.sinks.push_back(std::move(chunk.result.sinks.front()));
+        result.count += chunk.result.count;
+        if (chunk.result.error.has_value())
+        {
+            result.error = chunk.result.error;
+            break;
+        }
+    }
+    return result;
+}
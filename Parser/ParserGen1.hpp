@@ -23,7 +23,7 @@ Parser<std::tuple<L, R>> operator>>(const Parser<L> &left, const Parser<R> &righ
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return std::make_tuple(result_l.value(), result_r.value());
+                return std::make_tuple(std::move(result_l.value()), std::move(result_r.value()));
             }));
 }
 
@@ -45,7 +45,11 @@ Parser<std::vector<T>> operator>>(const Parser<T> &left, const Parser<T> &right)
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return std::vector<T>({result_l.value(), result_r.value()});
+                std::vector<T> result;
+                result.reserve(2);
+                result.push_back(std::move(result_l.value()));
+                result.push_back(std::move(result_r.value()));
+                return result;
             }));
 }
 
@@ -67,8 +71,8 @@ Parser<std::vector<T>> operator>>(const Parser<T> &left, const Parser<std::vecto
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                result_r.value().insert(result_r.value().begin(), result_l.value());
-                return result_r.value();
+                result_r.value().insert(result_r.value().begin(), std::move(result_l.value()));
+                return result_r;
             }));
 }
 
@@ -90,8 +94,8 @@ Parser<std::vector<T>> operator>>(const Parser<std::vector<T>> &left, const Pars
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                result_l.value().push_back(result_r.value());
-                return result_l.value();
+                result_l.value().push_back(std::move(result_r.value()));
+                return result_l;
             }));
 }
 
@@ -113,8 +117,9 @@ Parser<std::vector<T>> operator>>(const Parser<std::vector<T>> &left, const Pars
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                result_l.value().insert(result_l.value().end(), result_r.value().begin(), result_r.value().end());
-                return result_l.value();
+                result_l.value().insert(result_l.value().end(), std::make_move_iterator(result_r.value().begin()),
+                    std::make_move_iterator(result_r.value().end()));
+                return result_l;
             }));
 }
 
@@ -136,7 +141,7 @@ Parser<T> operator>>(const Parser<T> &left, const Parser<std::string> &right)
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return result_l.value();
+                return result_l;
             }));
 }
 
@@ -158,7 +163,7 @@ Parser<T> operator>>(const Parser<T> &left, const Parser<char> &right)
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return result_l.value();
+                return result_l;
             }));
 }
 
@@ -180,7 +185,7 @@ Parser<T> operator>>(const Parser<std::string> &left, const Parser<T> &right)
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return result_r.value();
+                return result_r;
             }));
 }
 
@@ -202,7 +207,7 @@ Parser<T> operator>>(const Parser<char> &left, const Parser<T> &right)
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return result_r.value();
+                return result_r;
             }));
 }
 
@@ -223,7 +228,8 @@ inline Parser<std::string> operator>>(const Parser<std::string> &left, const Par
                     return std::nullopt;
                 };
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return result_l.value() + result_r.value();
+                result_l.value().append(result_r.value());
+                return result_l;
             }));
 }
 
@@ -305,12 +311,12 @@ Parser<std::variant<L, R>> operator|(const Parser<L> &left, const Parser<R> &rig
                 std::optional<L> result_l = left(stream);
                 if (result_l.has_value())
                 {
-                    return result_l.value();
+                    return std::move(result_l.value());
                 }
                 std::optional<R> result_r = right(stream);
                 if (result_r.has_value())
                 {
-                    return result_r.value();
+                    return std::move(result_r.value());
                 };
                 return std::nullopt;
             }));
@@ -325,12 +331,12 @@ Parser<T> operator|(const Parser<T> &left, const Parser<T> &right)
                 std::optional<T> result_l = left(stream);
                 if (result_l.has_value())
                 {
-                    return result_l.value();
+                    return result_l;
                 }
                 std::optional<T> result_r = right(stream);
                 if (result_r.has_value())
                 {
-                    return result_r.value();
+                    return result_r;
                 };
                 return std::nullopt;
             }));
@@ -345,12 +351,14 @@ Parser<std::vector<T>> operator|(const Parser<T> &left, const Parser<std::vector
                 std::optional<T> result_l = left(stream);
                 if (result_l.has_value())
                 {
-                    return std::vector<T>({result_l.value()});
+                    std::vector<T> result;
+                    result.push_back(std::move(result_l.value()));
+                    return result;
                 }
                 std::optional<std::vector<T>> result_r = right(stream);
                 if (result_r.has_value())
                 {
-                    return result_r.value();
+                    return result_r;
                 };
                 return std::nullopt;
             }));
@@ -365,12 +373,14 @@ Parser<std::vector<T>> operator|(const Parser<std::vector<T>> &left, const Parse
                 std::optional<std::vector<T>> result_l = left(stream);
                 if (result_l.has_value())
                 {
-                    return result_l.value();
+                    return result_l;
                 }
                 std::optional<T> result_r = right(stream);
                 if (result_r.has_value())
                 {
-                    return std::vector<T>({result_r.value()});
+                    std::vector<T> result;
+                    result.push_back(std::move(result_r.value()));
+                    return result;
                 };
                 return std::nullopt;
             }));
@@ -444,7 +454,7 @@ Parser<std::vector<T>> operator*(const Parser<T> &parser)
                 std::vector<T> result;
                 while (temp.has_value())
                 {
-                    result.emplace_back(temp.value());
+                    result.emplace_back(std::move(temp.value()));
                     temp = parser(stream);
                 }
                 return result;
@@ -457,13 +467,13 @@ inline Parser<std::string> operator*(const Parser<char> &parser)
             ([=](std::string_view& stream)-> std::optional<std::string>
             {
                 std::optional<char> temp = parser(stream);
-                std::vector<char> result;
+                std::string result;
                 while (temp.has_value())
                 {
-                    result.emplace_back(temp.value());
+                    result.push_back(temp.value());
                     temp = parser(stream);
                 }
-                return std::string(result.begin(), result.end());
+                return result;
             }));
 }
 
@@ -476,7 +486,14 @@ inline Parser<std::string> operator*(const Parser<std::string> &parser)
                 std::string result;
                 while (temp.has_value())
                 {
-                    result.append(temp.value());
+                    if (result.empty())
+                    {
+                        result = std::move(temp.value());
+                    }
+                    else
+                    {
+                        result.append(temp.value());
+                    }
                     temp = parser(stream);
                 }
                 return result;
@@ -495,7 +512,7 @@ Parser<std::vector<T>> operator+(const Parser<T> &parser)
                 std::vector<T> result;
                 while (temp.has_value())
                 {
-                    result.emplace_back(temp.value());
+                    result.emplace_back(std::move(temp.value()));
                     temp = parser(stream);
                 }
                 if (result.empty())
@@ -515,10 +532,10 @@ inline Parser<std::string> operator+(const Parser<char> &parser)
             ([=](std::string_view& stream)-> std::optional<std::string>
             {
                 std::optional<char> temp = parser(stream);
-                std::vector<char> result;
+                std::string result;
                 while (temp.has_value())
                 {
-                    result.emplace_back(temp.value());
+                    result.push_back(temp.value());
                     temp = parser(stream);
                 }
                 if (result.empty())
@@ -527,7 +544,7 @@ inline Parser<std::string> operator+(const Parser<char> &parser)
                 }
                 else
                 {
-                    return std::string(result.begin(), result.end());
+                    return result;
                 }
             }));
 }
@@ -542,7 +559,14 @@ inline Parser<std::string> operator+(const Parser<std::string> &parser)
                 size_t count = 0;
                 while (temp.has_value())
                 {
-                    result.append(temp.value());
+                    if (result.empty())
+                    {
+                        result = std::move(temp.value());
+                    }
+                    else
+                    {
+                        result.append(temp.value());
+                    }
                     temp = parser(stream);
                     ++count;
                 }
@@ -570,10 +594,10 @@ Parser<std::string> operator~(const Parser<T> &parser)
                     return std::nullopt;
                 }
                 std::optional<T> temp = parser(stream);
-                std::vector<char> result;
+                std::string result;
                 while (!temp.has_value() && !stream.empty())
                 {
-                    result.emplace_back(stream.front());
+                    result.push_back(stream.front());
                     stream.remove_prefix(1);
                     temp = parser(stream);
                 }
@@ -583,7 +607,7 @@ Parser<std::string> operator~(const Parser<T> &parser)
                 }
                 else
                 {
-                    return std::string(result.cbegin(), result.cend());
+                    return result;
                 }
             }));
 }
@@ -621,7 +645,7 @@ Parser<L> operator-(const Parser<L> &left, const Parser<R> &right)
                 if (result.has_value())
                 {
                     stream.remove_prefix(start - sub_stream.length());
-                    return result.value();
+                    return result;
                 }
                 else
                 {
@@ -751,35 +775,41 @@ inline Parser<std::vector<char>> pair_p(const Parser<L> &left, const Parser<R> &
         }));
 }
 
+// parser at least min and at most max times, stopping at the first failure;
+// the input is left untouched when fewer than min matched
 template <typename T>
-inline Parser<std::vector<T>> repeat_p(const size_t times, const Parser<T> &parser)
+inline Parser<std::vector<T>> repeat_p(const size_t min, const size_t max, const Parser<T> &parser)
 {
     return Parser<std::vector<T>>(std::function<std::optional<std::vector<T>>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<std::vector<T>>
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-
+            std::string_view stream_copy(stream);
             std::vector<T> result;
+            // a capacity hint, a value normally takes at least one byte of input; a large or
+            // unbounded max reserves only min and lets the vector grow
+            result.reserve(std::min(max <= 64 ? max : min, stream.length()));
             std::optional<T> temp;
-            for (size_t i = 0; i < times; ++i)
+            while (result.size() < max)
             {
-                temp = parser(stream);
-                if (temp.has_value())
+                temp = parser(stream_copy);
+                if (!temp.has_value())
                 {
-                    result.emplace_back(temp.value());
+                    break;
                 }
+                result.emplace_back(std::move(temp.value()));
             }
 
-            if (result.size() == times)
-            {
-                return result;
-            }
-            else
+            if (result.size() < min)
             {
                 return std::nullopt;
             }
+            stream = stream_copy;
+            return result;
         }));
 }
+
+template <typename T>
+inline Parser<std::vector<T>> repeat_p(const size_t times, const Parser<T> &parser)
+{
+    return repeat_p(times, times, parser);
+}
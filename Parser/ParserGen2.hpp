@@ -1,5 +1,685 @@
 #pragma once
 #include "BaseParser.hpp"
+#include "Scan.hpp"
+
+
+namespace detail
+{
+
+template <typename T>
+inline bool match(const Parser<T> &parser, std::string_view &stream)
+{
+    if constexpr(std::is_same<T, bool>::value)
+    {
+        return parser(stream);
+    }
+    else
+    {
+        return parser(stream).has_value();
+    }
+}
+
+template <typename T>
+inline bool match(const std::reference_wrapper<Parser<T>> &parser, std::string_view &stream)
+{
+    return match(parser.get(), stream);
+}
+
+// parser as often as it matches; false, with stream restored, when the attempt that ended the
+// repetition failed past a cut
+template <typename P>
+bool repeat(const P &parser, std::string_view &stream)
+{
+    const Cut &cut = Cut::current();
+    const std::string_view start(stream);
+    for (;;)
+    {
+        const size_t passed = cut.passed;
+        if (!match(parser, stream))
+        {
+            if (cut.passed == passed)
+            {
+                return true;
+            }
+            stream = start;
+            return false;
+        }
+    }
+}
+
+// text of a delimiter that is a plain ch_p/str_p without actions, nullptr otherwise
+template <typename T>
+inline const std::string *literal_of(const Parser<T> &)
+{
+    return nullptr;
+}
+
+inline const std::string *literal_of(const Parser<char> &parser)
+{
+    return parser.literal.empty() || parser.call || parser.void_call ? nullptr : &parser.literal;
+}
+
+inline const std::string *literal_of(const Parser<std::string> &parser)
+{
+    return parser.literal.empty() || parser.call || parser.void_call ? nullptr : &parser.literal;
+}
+
+inline const std::string *literal_of(const Parser<std::string_view> &parser)
+{
+    return parser.literal.empty() || parser.call || parser.void_call ? nullptr : &parser.literal;
+}
+
+template <typename T>
+inline const std::string *literal_of(const std::reference_wrapper<Parser<T>> &parser)
+{
+    return literal_of(parser.get());
+}
+
+// character class of a single-byte class parser without actions, nullptr otherwise
+template <typename T>
+inline const CharSet *charset_of(const Parser<T> &)
+{
+    return nullptr;
+}
+
+inline const CharSet *charset_of(const Parser<char> &parser)
+{
+    return parser.call || parser.void_call ? nullptr : parser.charset.get();
+}
+
+inline const CharSet *charset_of(const Parser<std::string_view> &parser)
+{
+    return parser.call || parser.void_call ? nullptr : parser.charset.get();
+}
+
+template <typename T>
+inline const CharSet *charset_of(const std::reference_wrapper<Parser<T>> &parser)
+{
+    return charset_of(parser.get());
+}
+
+// FIRST set of a parser, nullptr when unknown;
+// a referenced rule may still be under construction, so refs never have one
+template <typename T>
+inline std::shared_ptr<const CharSet> first_of(const Parser<T> &parser)
+{
+    return parser.first;
+}
+
+template <typename T>
+inline std::shared_ptr<const CharSet> first_of(const std::reference_wrapper<Parser<T>> &)
+{
+    return nullptr;
+}
+
+inline std::shared_ptr<const CharSet> first_union(const std::shared_ptr<const CharSet> &left,
+    const std::shared_ptr<const CharSet> &right)
+{
+    if (left == nullptr || right == nullptr)
+    {
+        return nullptr;
+    }
+    return std::make_shared<const CharSet>(*left | *right);
+}
+
+template <typename P>
+inline P with_first(P parser, const std::shared_ptr<const CharSet> &first)
+{
+    parser.first = first;
+    return parser;
+}
+
+// appends a branch to an alternation, an action-free alternation is flattened into its branches
+template <typename P>
+inline void add_branch(Alternation<bool> &alternation, const P &parser)
+{
+    alternation.add([=](std::string_view &stream) { return match(parser, stream); }, first_of(parser));
+}
+
+inline void add_branch(Alternation<bool> &alternation, const Parser<bool> &parser)
+{
+    if (parser.alternation && !parser.call)
+    {
+        alternation.append(*parser.alternation);
+    }
+    else if (!parser.call)
+    {
+        alternation.add(parser.func, parser.first);
+    }
+    else
+    {
+        alternation.add([=](std::string_view &stream) { return parser(stream); }, parser.first);
+    }
+}
+
+inline void add_branch(Alternation<std::string> &alternation, const Parser<std::string> &parser)
+{
+    if (parser.alternation && !parser.call && !parser.void_call)
+    {
+        alternation.append(*parser.alternation);
+    }
+    else if (!parser.call && !parser.void_call)
+    {
+        alternation.add(parser.func, parser.first);
+    }
+    else
+    {
+        alternation.add([=](std::string_view &stream) { return parser(stream); }, parser.first);
+    }
+}
+
+inline void add_branch(Alternation<std::string> &alternation, const Parser<char> &parser)
+{
+    alternation.add([=](std::string_view &stream) -> std::optional<std::string>
+        {
+            const std::optional<char> result = parser(stream);
+            if (result.has_value())
+            {
+                return std::string({result.value()});
+            }
+            return std::nullopt;
+        }, parser.first);
+}
+
+// left | right, dispatched on the first byte once the chain is flattened
+template <typename T, typename L, typename R>
+Parser<T> alternation_p(const L &left, const R &right)
+{
+    const std::shared_ptr<Alternation<T>> alternation = std::make_shared<Alternation<T>>();
+    add_branch(*alternation, left);
+    add_branch(*alternation, right);
+    alternation->build();
+
+    Parser<T> parser(typename Alternation<T>::Branch([=](std::string_view &stream)
+        {
+            return (*alternation)(stream);
+        }));
+    parser.first = alternation->first();
+    parser.alternation = alternation;
+    return parser;
+}
+
+// offset of the first position where right matches, stream.length() if there is none,
+// matched is set to the length right consumed there
+template <typename R>
+size_t until_length(const R &right, const std::string_view stream, size_t &matched)
+{
+    if (const std::string *literal = literal_of(right))
+    {
+        const size_t pos = stream.find(*literal);
+        matched = pos == std::string_view::npos ? 0 : literal->length();
+        return pos == std::string_view::npos ? stream.length() : pos;
+    }
+    const FailureMute mute;
+    for (size_t i = 0; ; ++i)
+    {
+        std::string_view probe = stream.substr(i);
+        if (match(right, probe))
+        {
+            matched = stream.length() - i - probe.length();
+            return i;
+        }
+        if (probe.empty())
+        {
+            matched = 0;
+            return i;
+        }
+    }
+}
+
+// length of left, body and right, where the body is at least one byte up to the first right
+template <typename L, typename R>
+std::optional<size_t> confix_length(const L &left, const R &right, const std::string_view stream)
+{
+    if (stream.empty())
+    {
+        return std::nullopt;
+    }
+    std::string_view stream_copy(stream);
+    if (!match(left, stream_copy))
+    {
+        return std::nullopt;
+    }
+    size_t matched = 0;
+    const size_t body = until_length(right, stream_copy, matched);
+    if (body == 0)
+    {
+        return std::nullopt;
+    }
+    return stream.length() - stream_copy.length() + body + matched;
+}
+
+struct PairSpan
+{
+    size_t left = 0;
+    size_t length = 0;
+    size_t right = 0;
+};
+
+// a balanced left ... right block, nested pairs included;
+// literal delimiters are found with a byte scan instead of trying both parsers at every offset
+template <typename L, typename R>
+std::optional<PairSpan> pair_span(const L &left, const R &right, const std::string_view stream)
+{
+    if (stream.empty())
+    {
+        return std::nullopt;
+    }
+    std::string_view stream_copy(stream);
+    if (!match(left, stream_copy))
+    {
+        return std::nullopt;
+    }
+    PairSpan span;
+    span.left = stream.length() - stream_copy.length();
+    size_t pari_count = 1;
+
+    const std::string *left_literal = literal_of(left), *right_literal = literal_of(right);
+    if (left_literal != nullptr && right_literal != nullptr && left_literal->length() == 1
+        && right_literal->length() == 1 && left_literal->front() != right_literal->front())
+    {
+        span.length = Scan::find_pair_end(stream, span.left, left_literal->front(), right_literal->front(), 1);
+        if (span.length > stream.length())
+        {
+            track_failure(stream.substr(stream.length()), first_of(right).get());
+            return std::nullopt;
+        }
+        span.right = 1;
+        return span;
+    }
+    else if (left_literal != nullptr && right_literal != nullptr)
+    {
+        size_t pos = span.left;
+        while (pari_count > 0)
+        {
+            pos = Scan::find_either(stream, pos, right_literal->front(), left_literal->front());
+            if (pos == stream.length())
+            {
+                track_failure(stream.substr(stream.length()), first_of(right).get());
+                return std::nullopt;
+            }
+            if (stream.compare(pos, right_literal->length(), *right_literal) == 0)
+            {
+                --pari_count;
+                pos += right_literal->length();
+                span.right = right_literal->length();
+            }
+            else if (stream.compare(pos, left_literal->length(), *left_literal) == 0)
+            {
+                ++pari_count;
+                pos += left_literal->length();
+            }
+            else
+            {
+                ++pos;
+            }
+        }
+        span.length = pos;
+        return span;
+    }
+
+    size_t temp = 0;
+    {
+        const FailureMute mute;
+        while (pari_count > 0 && !stream_copy.empty())
+        {
+            temp = stream_copy.length();
+            if (match(right, stream_copy))
+            {
+                --pari_count;
+                span.right = temp - stream_copy.length();
+            }
+            else if (!match(left, stream_copy))
+            {
+                stream_copy.remove_prefix(1);
+            }
+            else
+            {
+                ++pari_count;
+            }
+        }
+    }
+    if (pari_count == 0)
+    {
+        span.length = stream.length() - stream_copy.length();
+        return span;
+    }
+    else
+    {
+        // the closing delimiter was expected before the end of the input
+        track_failure(stream_copy, first_of(right).get());
+        return std::nullopt;
+    }
+}
+
+template <typename L, typename R>
+std::optional<size_t> pair_length(const L &left, const R &right, const std::string_view stream)
+{
+    const std::optional<PairSpan> span = pair_span(left, right, stream);
+    if (span.has_value())
+    {
+        return span.value().length;
+    }
+    else
+    {
+        return std::nullopt;
+    }
+}
+
+// left ... right where exp has to consume everything between the outermost pair
+template <typename A, typename B, typename C>
+bool pair_parse(const A &left, const B &exp, const C &right, std::string_view &stream)
+{
+    const std::optional<PairSpan> span = pair_span(left, right, stream);
+    if (!span.has_value())
+    {
+        return false;
+    }
+    std::string_view inner = stream.substr(span.value().left,
+        span.value().length - span.value().left - span.value().right);
+    match(exp, inner);
+    if (inner.empty())
+    {
+        stream.remove_prefix(span.value().length);
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+
+// bytes no match of parser starts with, nullptr when its FIRST set is unknown
+template <typename P>
+std::shared_ptr<const CharSet> skip_of(const P &parser)
+{
+    const std::shared_ptr<const CharSet> first = first_of(parser);
+    return first == nullptr ? nullptr : std::make_shared<const CharSet>(~*first);
+}
+
+// length of stream up to and including the first sync point, stream.length() if there is none;
+// a sync point has to consume something, skip is the skip_of(sync) when it is known
+template <typename S>
+size_t resync_length(const S &sync, const CharSet *skip, const std::string_view stream)
+{
+    const std::string *literal = literal_of(sync);
+    if (literal != nullptr && !literal->empty())
+    {
+        const size_t pos = literal->length() == 1
+            ? Scan::find_either(stream, 0, literal->front(), literal->front()) : stream.find(*literal);
+        return pos >= stream.length() ? stream.length() : pos + literal->length();
+    }
+    const FailureMute mute;
+    for (size_t i = 0; i < stream.length(); ++i)
+    {
+        if (skip != nullptr)
+        {
+            i = Scan::span_of(*skip, stream, i);
+            if (i == stream.length())
+            {
+                break;
+            }
+        }
+        std::string_view probe = stream.substr(i);
+        if (match(sync, probe) && probe.length() < stream.length() - i)
+        {
+            return stream.length() - probe.length();
+        }
+    }
+    return stream.length();
+}
+
+// record, or when it fails, everything up to and including the next sync point, logged to the
+// Recovery of this thread
+template <typename R, typename S>
+bool recover(const R &record, const S &sync, const CharSet *skip, std::string_view &stream)
+{
+    std::string_view stream_copy(stream);
+    if (match(record, stream_copy))
+    {
+        stream = stream_copy;
+        return true;
+    }
+    Recovery *recovery = Context<Recovery>::current();
+    if (stream.empty() || recovery == nullptr || recovery->skipped.size() >= recovery->limit)
+    {
+        return false;
+    }
+
+    const size_t length = resync_length(sync, skip, stream);
+    Recovery::Skipped skipped{stream.substr(0, length), Failure()};
+    if (Failure *failure = Context<Failure>::current())
+    {
+        // the record's own failures start at its first byte, anything before is stale
+        if (failure->failed() && failure->position >= stream.data())
+        {
+            skipped.failure = std::move(*failure);
+        }
+        else
+        {
+            skipped.failure.fail(stream.data(), first_of(record).get());
+        }
+        failure->reset();
+    }
+    recovery->skipped.push_back(std::move(skipped));
+    stream.remove_prefix(length);
+    return true;
+}
+
+inline void append_value(std::string &result, const char value)
+{
+    result.push_back(value);
+}
+
+inline void append_value(std::string &result, std::string &&value)
+{
+    if (result.empty())
+    {
+        result = std::move(value);
+    }
+    else
+    {
+        result.append(value);
+    }
+}
+
+// one value of a separated list, a value that is not bool is handed to emit
+template <typename T, typename E>
+bool list_element(const Parser<T> &value, std::string_view &stream, const E &emit)
+{
+    if constexpr(std::is_same<T, bool>::value)
+    {
+        return value(stream);
+    }
+    else
+    {
+        std::optional<T> result = value(stream);
+        if (!result.has_value())
+        {
+            return false;
+        }
+        emit(std::move(result.value()));
+        return true;
+    }
+}
+
+template <typename T, typename E>
+bool list_element(const std::reference_wrapper<Parser<T>> &value, std::string_view &stream, const E &emit)
+{
+    return list_element(value.get(), stream, emit);
+}
+
+// value (sep value)* in one loop, a separator is only consumed when a value follows it;
+// a literal separator such as ch_p(',') is compared in place instead of being called
+template <typename V, typename S, typename E>
+bool sep_by(const V &value, const S &sep, std::string_view &stream, const E &emit)
+{
+    std::string_view stream_copy(stream);
+    if (!list_element(value, stream_copy, emit))
+    {
+        return false;
+    }
+    const std::string *literal = literal_of(sep);
+    const Cut &cut = Cut::current();
+    for (;;)
+    {
+        std::string_view next(stream_copy);
+        const size_t passed = cut.passed;
+        if (literal != nullptr && literal->length() == 1)
+        {
+            if (next.empty() || next.front() != literal->front())
+            {
+                break;
+            }
+            next.remove_prefix(1);
+        }
+        else if (literal != nullptr)
+        {
+            if (next.substr(0, literal->length()) != *literal)
+            {
+                break;
+            }
+            next.remove_prefix(literal->length());
+        }
+        else if (!match(sep, next))
+        {
+            if (cut.passed != passed)
+            {
+                return false;
+            }
+            break;
+        }
+        if (!list_element(value, next, emit))
+        {
+            if (cut.passed != passed)
+            {
+                return false;
+            }
+            break;
+        }
+        stream_copy = next;
+    }
+    stream = stream_copy;
+    return true;
+}
+
+template <typename V, typename S>
+Parser<bool> sep_by_parser(const V &value, const S &sep)
+{
+    return Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
+        {
+            return sep_by(value, sep, stream, [](auto &&) {});
+        }));
+}
+
+// sep_by appending the values to the output member of object, or of the Context<C> of the
+// parsing thread; what a failed list appended is removed again
+template <typename T, typename V, typename S, typename C>
+Parser<bool> sep_by_parser(const V &value, const S &sep, std::vector<T> C::*output, const size_t capacity, C *object)
+{
+    return Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
+        {
+            C *state = object != nullptr ? object : Context<C>::current();
+            if (state == nullptr)
+            {
+                return sep_by(value, sep, stream, [](T &&) {});
+            }
+            std::vector<T> &values = state->*output;
+            const size_t size = values.size();
+            if (values.capacity() < size + capacity)
+            {
+                // grow geometrically, reserving exactly size + capacity per list is quadratic
+                // when the vector collects many lists
+                values.reserve(std::max(size + capacity, 2 * values.capacity()));
+            }
+            if (!sep_by(value, sep, stream, [&](T &&result) { values.push_back(std::move(result)); }))
+            {
+                values.erase(values.begin() + size, values.end());
+                return false;
+            }
+            return true;
+        }));
+}
+
+// min to max matches of parser, stopping at the first failure or at a failure past a cut;
+// Parser<bool> keeps no values, Parser<std::string> concatenates them and
+// Parser<std::string_view> is the slice of the input they span
+template <typename R, typename P>
+Parser<R> repeat_range(const size_t min, const size_t max, const P &parser)
+{
+    using Result = std::conditional_t<std::is_same<R, bool>::value, bool, std::optional<R>>;
+    return Parser<R>(std::function<Result(std::string_view &)>(
+        [=](std::string_view &stream) -> Result
+        {
+            std::string_view stream_copy(stream);
+            std::string values;
+            size_t count = 0;
+            if (const CharSet *set = charset_of(parser))
+            {
+                count = Scan::span_of(*set, stream_copy.substr(0, max));
+                stream_copy.remove_prefix(count);
+            }
+            else
+            {
+                if constexpr(std::is_same<R, std::string>::value && std::is_same<decltype(parser(stream)), std::optional<char>>::value)
+                {
+                    // only a small max is reserved, an unbounded one would take the whole input
+                    values.reserve(std::min(max <= 64 ? max : min, stream.length()));
+                }
+                const Cut &cut = Cut::current();
+                for (; count < max; ++count)
+                {
+                    const size_t passed = cut.passed;
+                    bool matched = false;
+                    if constexpr(std::is_same<R, std::string>::value)
+                    {
+                        auto value = parser(stream_copy);
+                        if (value.has_value())
+                        {
+                            append_value(values, std::move(value.value()));
+                            matched = true;
+                        }
+                    }
+                    else
+                    {
+                        matched = match(parser, stream_copy);
+                    }
+                    if (!matched)
+                    {
+                        if (cut.passed != passed)
+                        {
+                            return Result();
+                        }
+                        break;
+                    }
+                }
+            }
+            if (count < min)
+            {
+                return Result();
+            }
+
+            const std::string_view matched = stream.substr(0, stream.length() - stream_copy.length());
+            stream = stream_copy;
+            if constexpr(std::is_same<R, bool>::value)
+            {
+                return true;
+            }
+            else if constexpr(std::is_same<R, std::string_view>::value)
+            {
+                return matched;
+            }
+            else
+            {
+                return charset_of(parser) != nullptr ? std::string(matched) : std::move(values);
+            }
+        }));
+}
+
+};
 
 
 // operator>>
@@ -7,7 +687,7 @@
 template <typename L, typename R>
 Parser<bool> operator>>(const Parser<L> &left, const Parser<R> &right)
 {
-    return Parser<bool>(std::function<bool(std::string_view &stream)>
+    return detail::with_first(Parser<bool>(std::function<bool(std::string_view &stream)>
             ([=](std::string_view &stream)-> bool
             {
                 std::string_view stream_copy(stream);
@@ -43,12 +723,12 @@ Parser<bool> operator>>(const Parser<L> &left, const Parser<R> &right)
 
                 stream.remove_prefix(stream.length() - stream_copy.length());
                 return true;
-            }));
+            })), detail::first_of(left));
 }
 
 inline Parser<std::string> operator>>(const Parser<char> &left, const Parser<char> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 std::string_view stream_copy(stream);
@@ -66,12 +746,12 @@ inline Parser<std::string> operator>>(const Parser<char> &left, const Parser<cha
 
                 stream.remove_prefix(stream.length() - stream_copy.length());
                 return std::string({result_left.value(), result_right.value()});
-            }));
+            })), detail::first_of(left));
 }
 
 inline Parser<std::string> operator>>(const Parser<char> &left, const Parser<std::string> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 std::string_view stream_copy(stream);
@@ -90,12 +770,12 @@ inline Parser<std::string> operator>>(const Parser<char> &left, const Parser<std
                 stream.remove_prefix(stream.length() - stream_copy.length());
                 result_right.value().insert(result_right.value().begin(), result_left.value());
                 return result_right;
-            }));
+            })), detail::first_of(left));
 }
 
 inline Parser<std::string> operator>>(const Parser<std::string> &left, const Parser<char> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 std::string_view stream_copy(stream);
@@ -114,12 +794,12 @@ inline Parser<std::string> operator>>(const Parser<std::string> &left, const Par
                 stream.remove_prefix(stream.length() - stream_copy.length());
                 result_left.value().push_back(result_right.value());
                 return result_left;
-            }));
+            })), detail::first_of(left));
 }
 
 inline Parser<std::string> operator>>(const Parser<std::string> &left, const Parser<std::string> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 std::string_view stream_copy(stream);
@@ -136,8 +816,9 @@ inline Parser<std::string> operator>>(const Parser<std::string> &left, const Par
                 }
 
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return result_left.value() + result_right.value();
-            }));
+                result_left.value().append(result_right.value());
+                return result_left;
+            })), detail::first_of(left));
 }
 
 // operator|
@@ -145,96 +826,49 @@ inline Parser<std::string> operator>>(const Parser<std::string> &left, const Par
 template <typename L, typename R>
 Parser<bool> operator|(const Parser<L> &left, const Parser<R> &right)
 {
-    return Parser<bool>(std::function<bool(std::string_view &stream)>
-            ([=](std::string_view &stream)-> bool
-            {
-                if constexpr(std::is_same<L, bool>::value && std::is_same<R, bool>::value)
-                {
-                    return left(stream) || right(stream);
-                }
-                else if constexpr(std::is_same<L, bool>::value)
-                {
-                    return left(stream) || right(stream).has_value();
-                }
-                else if constexpr(std::is_same<R, bool>::value)
-                {
-                    return left(stream).has_value() || right(stream);
-                }
-                else
-                {
-                    return left(stream).has_value() || right(stream).has_value();
-                }
-            }));
+    return detail::alternation_p<bool>(left, right);
 }
 
 inline Parser<char> operator|(const Parser<char> &left, const Parser<char> &right)
 {
-    return Parser<char>(std::function<std::optional<char>(std::string_view &stream)>
+    const CharSet *left_set = detail::charset_of(left), *right_set = detail::charset_of(right);
+    if (left_set != nullptr && right_set != nullptr)
+    {
+        return charset_p(*left_set | *right_set);
+    }
+    return detail::with_first(Parser<char>(std::function<std::optional<char>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<char>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<char> result = left(stream);
                 if (result.has_value())
                 {
                     return result;
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
                 }
-            }));
+            })), detail::first_union(left.first, right.first));
 }
 
 inline Parser<std::string> operator|(const Parser<std::string> &left, const Parser<char> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
-            ([=](std::string_view &stream)-> std::optional<std::string>
-            {
-                std::optional<std::string> result_left = left(stream);
-                if (result_left.has_value())
-                {
-                    return result_left;
-                }
-                std::optional<char> result_right = right(stream);
-                if (result_right.has_value())
-                {
-                    return std::string({result_right.value()});
-                }
-                return result_left;
-            }));
+    return detail::alternation_p<std::string>(left, right);
 }
 
 inline Parser<std::string> operator|(const Parser<char> &left, const Parser<std::string> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
-            ([=](std::string_view &stream)-> std::optional<std::string>
-            {
-                std::optional<char> result_left = left(stream);
-                if (result_left.has_value())
-                {
-                    return std::string({result_left.value()});
-                }
-                else
-                {
-                    return right(stream);
-                }
-            }));
+    return detail::alternation_p<std::string>(left, right);
 }
 
 inline Parser<std::string> operator|(const Parser<std::string> &left, const Parser<std::string> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
-            ([=](std::string_view &stream)-> std::optional<std::string>
-            {
-                std::optional<std::string> result = left(stream);
-                if (result.has_value())
-                {
-                    return result;
-                }
-                else
-                {
-                    return right(stream);
-                }
-            }));
+    return detail::alternation_p<std::string>(left, right);
 }
 
 // operator!
@@ -249,8 +883,8 @@ Parser<bool> operator!(const Parser<T> &parser)
                 {
                     return true;
                 }
-                parser(stream);
-                return true;
+                const size_t passed = Cut::current().passed;
+                return detail::match(parser, stream) || Cut::current().passed == passed;
             }));
 }
 
@@ -308,15 +942,7 @@ Parser<bool> operator*(const Parser<T> &parser)
                 {
                     return true;
                 }
-                if constexpr(std::is_same<T, bool>::value)
-                {
-                    while (parser(stream));
-                }
-                else
-                {
-                    while (parser(stream).has_value());
-                }
-                return true;
+                return detail::repeat(parser, stream);
             }));
 }
 
@@ -329,14 +955,21 @@ inline Parser<std::string> operator*(const Parser<char> &parser)
                 {
                     return std::string();
                 }
+                if (const CharSet *set = detail::charset_of(parser))
+                {
+                    const size_t length = Scan::span_of(*set, stream);
+                    std::string result(stream.substr(0, length));
+                    stream.remove_prefix(length);
+                    return result;
+                }
                 std::optional<char> temp = parser(stream);
-                std::vector<char> result;
+                std::string result;
                 while (temp.has_value())
                 {
                     result.push_back(temp.value());
                     temp = parser(stream);
                 }
-                return std::string(result.begin(), result.end());
+                return result;
             }));
 }
 
@@ -353,7 +986,14 @@ inline Parser<std::string> operator*(const Parser<std::string> &parser)
                 std::string result;
                 while (temp.has_value())
                 {
-                    result.append(temp.value());
+                    if (result.empty())
+                    {
+                        result = std::move(temp.value());
+                    }
+                    else
+                    {
+                        result.append(temp.value());
+                    }
                     temp = parser(stream);
                 }
                 return result;
@@ -365,51 +1005,45 @@ inline Parser<std::string> operator*(const Parser<std::string> &parser)
 template <typename T>
 Parser<bool> operator+(const Parser<T> &parser)
 {
-    return Parser<bool>(std::function<bool(std::string_view &stream)>
+    return detail::with_first(Parser<bool>(std::function<bool(std::string_view &stream)>
             ([=](std::string_view &stream)-> bool
             {
                 if (stream.empty())
                 {
                     return false;
                 }
-                if constexpr(std::is_same<T, bool>::value)
-                {
-                    if (parser(stream))
-                    {
-                        while (parser(stream));
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
-                }
-                else
+                std::string_view stream_copy(stream);
+                if (!detail::match(parser, stream_copy) || !detail::repeat(parser, stream_copy))
                 {
-                    if (parser(stream).has_value())
-                    {
-                        while (parser(stream).has_value());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    return false;
                 }
-            }));
+                stream = stream_copy;
+                return true;
+            })), detail::first_of(parser));
 }
 
 inline Parser<std::string> operator+(const Parser<char> &parser)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 if (stream.empty())
                 {
                     return std::nullopt;
                 }
+                if (const CharSet *set = detail::charset_of(parser))
+                {
+                    const size_t length = Scan::span_of(*set, stream);
+                    if (length == 0)
+                    {
+                        return std::nullopt;
+                    }
+                    std::string result(stream.substr(0, length));
+                    stream.remove_prefix(length);
+                    return result;
+                }
                 std::optional<char> temp = parser(stream);
-                std::vector<char> result;
+                std::string result;
                 while (temp.has_value())
                 {
                     result.push_back(temp.value());
@@ -421,14 +1055,14 @@ inline Parser<std::string> operator+(const Parser<char> &parser)
                 }
                 else
                 {
-                    return std::string(result.begin(), result.end());
+                    return result;
                 }
-            }));
+            })), detail::first_of(parser));
 }
 
 inline Parser<std::string> operator+(const Parser<std::string> &parser)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 if (stream.empty())
@@ -440,7 +1074,14 @@ inline Parser<std::string> operator+(const Parser<std::string> &parser)
                 size_t count = 0;
                 while (temp.has_value())
                 {
-                    result.append(temp.value());
+                    if (result.empty())
+                    {
+                        result = std::move(temp.value());
+                    }
+                    else
+                    {
+                        result.append(temp.value());
+                    }
                     temp = parser(stream);
                     ++count;
                 }
@@ -452,7 +1093,7 @@ inline Parser<std::string> operator+(const Parser<std::string> &parser)
                 {
                     return std::nullopt;
                 }
-            }));
+            })), detail::first_of(parser));
 }
 
 // operator~
@@ -467,22 +1108,15 @@ Parser<std::string> operator~(const Parser<T> &parser)
                 {
                     return std::nullopt;
                 }
-                std::optional<T> temp = parser(stream);
-                std::vector<char> result;
-                while (!temp.has_value() && !stream.empty())
-                {
-                    result.emplace_back(stream.front());
-                    stream.remove_prefix(1);
-                    temp = parser(stream);
-                }
-                if (result.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(parser, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
-                else
-                {
-                    return std::string(result.cbegin(), result.cend());
-                }
+                std::string result(stream.substr(0, length));
+                stream.remove_prefix(length + matched);
+                return result;
             }));
 }
 
@@ -491,7 +1125,7 @@ Parser<std::string> operator~(const Parser<T> &parser)
 template <typename L, typename R>
 Parser<bool> operator-(const Parser<L> &left, const Parser<R> &right)
 {
-    return Parser<bool>(std::function<bool(std::string_view &stream)>
+    return detail::with_first(Parser<bool>(std::function<bool(std::string_view &stream)>
             ([=](std::string_view &stream)-> bool
             {
                 if (stream.empty())
@@ -499,66 +1133,30 @@ Parser<bool> operator-(const Parser<L> &left, const Parser<R> &right)
                     return false;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return false;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
-                if constexpr(std::is_same<L, bool>::value)
+                std::string_view sub_stream = stream.substr(0, length);
+                if (detail::match(left, sub_stream))
                 {
-                    if (left(sub_stream))
-                    {
-                        stream.remove_prefix(start - sub_stream.length());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    stream.remove_prefix(length - sub_stream.length());
+                    return true;
                 }
                 else
                 {
-                    if (left(sub_stream).has_value())
-                    {
-                        stream.remove_prefix(start - sub_stream.length());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    return false;
                 }
-            }));
+            })), detail::first_of(left));
 }
 
 template <typename R>
 Parser<char> operator-(const Parser<char> &left, const Parser<R> &right)
 {
-    return Parser<char>(std::function<std::optional<char>(std::string_view &stream)>
+    return detail::with_first(Parser<char>(std::function<std::optional<char>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<char>
             {
                 if (stream.empty())
@@ -566,52 +1164,31 @@ Parser<char> operator-(const Parser<char> &left, const Parser<R> &right)
                     return std::nullopt;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
+                std::string_view sub_stream = stream.substr(0, length);
                 std::optional<char> result = left(sub_stream);
                 if (result.has_value())
                 {
-                    stream.remove_prefix(start - sub_stream.length());
+                    stream.remove_prefix(length - sub_stream.length());
                     return result;
                 }
                 else
                 {
                     return std::nullopt;
                 }
-            }));
+            })), detail::first_of(left));
 }
 
 template <typename R>
 Parser<std::string> operator-(const Parser<std::string> &left, const Parser<R> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 if (stream.empty())
@@ -619,46 +1196,25 @@ Parser<std::string> operator-(const Parser<std::string> &left, const Parser<R> &
                     return std::nullopt;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
+                std::string_view sub_stream = stream.substr(0, length);
                 std::optional<std::string> result = left(sub_stream);
                 if (result.has_value())
                 {
-                    stream.remove_prefix(start - sub_stream.length());
+                    stream.remove_prefix(length - sub_stream.length());
                     return result;
                 }
                 else
                 {
                     return std::nullopt;
                 }
-            }));
+            })), detail::first_of(left));
 }
 
 // functions
@@ -672,61 +1228,18 @@ inline auto confix_p(const Parser<A> &left, const Parser<B> &exp, const Parser<C
 template <typename L, typename R>
 inline Parser<std::string> confix_p(const Parser<L> &left, const Parser<R> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<std::string>
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<L, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return std::nullopt;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return std::nullopt;
-                }
-            }
-
-            std::vector<char> temp_string;
-            if constexpr(std::is_same<R, bool>::value)
-            {
-                bool temp = right(stream_copy);
-                while (!temp && !stream_copy.empty())
-                {
-                    temp_string.emplace_back(stream_copy.front());
-                    stream_copy.remove_prefix(1);
-                    temp = right(stream_copy);
-                }
-            }
-            else
-            {
-                std::optional<R> temp = right(stream_copy);
-                while (!temp.has_value() && !stream_copy.empty())
-                {
-                    temp_string.emplace_back(stream_copy.front());
-                    stream_copy.remove_prefix(1);
-                    temp = right(stream_copy);
-                }
-            }
-            if (temp_string.empty())
+            const std::optional<size_t> length = detail::confix_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
-            else
-            {
-                std::string result(stream.begin(), stream.begin() + stream.length() - stream_copy.length());
-                stream.remove_prefix(stream.length() - stream_copy.length());
-                return result;
-            }
-        }));
+            std::string result(stream.substr(0, length.value()));
+            stream.remove_prefix(length.value());
+            return result;
+        })), detail::first_of(left));
 }
 
 template <typename A, typename B>
@@ -735,237 +1248,253 @@ inline auto list_p(const Parser<A> &value, const Parser<B> &exp)
     return value >> *(exp >> value);
 }
 
+// value (sep value)*, like list_p but parsed in a single loop: a separator is only consumed
+// when a value follows it, and a literal separator is compared without calling a parser
+template <typename A, typename B>
+inline Parser<bool> sep_by_p(const Parser<A> &value, const Parser<B> &sep)
+{
+    return detail::with_first(detail::sep_by_parser(value, sep), detail::first_of(value));
+}
+
+// the same, appending the values to the vector output of object, or of the Context<C> of the
+// parsing thread when object is nullptr; capacity is reserved beyond the current size first.
+//     str_p("PA") >> sep_by_p(int_p(), ch_p(','), &Plotter::coordinates, 16)
+template <typename T, typename B, typename C>
+inline Parser<bool> sep_by_p(const Parser<T> &value, const Parser<B> &sep, std::vector<T> C::*output,
+    const size_t capacity = 0, C *object = nullptr)
+{
+    return detail::with_first(detail::sep_by_parser(value, sep, output, capacity, object), detail::first_of(value));
+}
+
 template <typename L, typename R>
 Parser<std::string> pair_p(const Parser<L> &left, const Parser<R> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<std::string>
         {
-            if (stream.empty())
+            const std::optional<size_t> length = detail::pair_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<L, bool>::value)
+            std::string result(stream.substr(0, length.value()));
+            stream.remove_prefix(length.value());
+            return result;
+        })), detail::first_of(left));
+}
+
+template <typename A, typename B, typename C>
+Parser<bool> pair_p(const Parser<A> &left, const Parser<B> &exp, const Parser<C> &right)
+{
+    return detail::with_first(Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
+        {
+            return detail::pair_parse(left, exp, right, stream);
+        })), detail::first_of(left));
+}
+
+// parser at least min and at most max times, stopping at the first failure;
+// the input is left untouched when fewer than min matched
+template <typename T>
+Parser<bool> repeat_p(const size_t min, const size_t max, const Parser<T> &parser)
+{
+    return detail::with_first(detail::repeat_range<bool>(min, max, parser), min > 0 ? detail::first_of(parser) : nullptr);
+}
+
+template <typename T>
+Parser<bool> repeat_p(const size_t times, const Parser<T> &parser)
+{
+    return repeat_p(times, times, parser);
+}
+
+inline Parser<std::string> repeat_p(const size_t min, const size_t max, const Parser<char> &parser)
+{
+    return detail::with_first(detail::repeat_range<std::string>(min, max, parser), min > 0 ? detail::first_of(parser) : nullptr);
+}
+
+inline Parser<std::string> repeat_p(const size_t times, const Parser<char> &parser)
+{
+    return repeat_p(times, times, parser);
+}
+
+inline Parser<std::string> repeat_p(const size_t min, const size_t max, const Parser<std::string> &parser)
+{
+    return detail::with_first(detail::repeat_range<std::string>(min, max, parser), min > 0 ? detail::first_of(parser) : nullptr);
+}
+
+inline Parser<std::string> repeat_p(const size_t times, const Parser<std::string> &parser)
+{
+    return repeat_p(times, times, parser);
+}
+
+
+// record, and in place of every record that fails, the input up to and including the next sync
+// point, so *recover_p(record, sync) parses the good records of a file in one pass.
+// Skipped records are logged to the Recovery installed on the thread, see Failure.hpp; actions
+// that a failed record already ran are not undone. A literal sync point is found with a byte
+// scan, any other one is only tried where its FIRST set allows.
+template <typename R, typename S>
+Parser<bool> recover_p(const Parser<R> &record, const Parser<S> &sync)
+{
+    const std::shared_ptr<const CharSet> skip = detail::skip_of(sync);
+    return Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
+        {
+            return detail::recover(record, sync, skip.get(), stream);
+        }));
+}
+
+// string_view operators and functions
+// results are slices of the input stream, nothing is copied or allocated
+
+
+inline Parser<std::string_view> operator>>(const Parser<std::string_view> &left, const Parser<std::string_view> &right)
+{
+    return detail::with_first(Parser<std::string_view>(std::function<std::optional<std::string_view>(std::string_view &stream)>
+            ([=](std::string_view &stream)-> std::optional<std::string_view>
             {
-                if (!left(stream_copy))
+                std::string_view stream_copy(stream);
+                if (!left(stream_copy).has_value() || !right(stream_copy).has_value())
                 {
                     return std::nullopt;
                 }
-            }
-            else
+                const std::string_view result = stream.substr(0, stream.length() - stream_copy.length());
+                stream = stream_copy;
+                return result;
+            })), detail::first_of(left));
+}
+
+inline Parser<std::string_view> operator|(const Parser<std::string_view> &left, const Parser<std::string_view> &right)
+{
+    return detail::with_first(Parser<std::string_view>(std::function<std::optional<std::string_view>(std::string_view &stream)>
+            ([=](std::string_view &stream)-> std::optional<std::string_view>
             {
-                if (!left(stream_copy).has_value())
+                const size_t passed = Cut::current().passed;
+                std::optional<std::string_view> result = left(stream);
+                if (result.has_value())
                 {
-                    return std::nullopt;
+                    return result;
                 }
-            }
-
-            size_t pari_count = 1;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                if constexpr(std::is_same<R, bool>::value)
+                else if (Cut::current().passed != passed)
                 {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        continue;
-                    }
+                    return std::nullopt;
                 }
                 else
                 {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        continue;
-                    }
+                    return right(stream);
                 }
-                
-                if constexpr(std::is_same<L, bool>::value)
+            })), detail::first_union(left.first, right.first));
+}
+
+inline Parser<std::string_view> operator!(const Parser<std::string_view> &parser)
+{
+    return Parser<std::string_view>(std::function<std::optional<std::string_view>(std::string_view &stream)>
+            ([=](std::string_view &stream)-> std::optional<std::string_view>
+            {
+                if (stream.empty())
                 {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
+                    return stream;
                 }
-                else
+                std::optional<std::string_view> result = parser(stream);
+                if (result.has_value())
                 {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
+                    return result;
                 }
-
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string result(stream.begin(), stream.begin() + stream.length() - stream_copy.length());
-                stream.remove_prefix(stream.length() - stream_copy.length());
-                return result;
-            }
-            else
-            {
-                return std::nullopt;
-            }
-        }));
+                else
+                {
+                    return stream.substr(0, 0);
+                }
+            }));
 }
 
-template <typename A, typename B, typename C>
-Parser<bool> pair_p(const Parser<A> &left, const Parser<B> &exp, const Parser<C> &right)
+inline Parser<std::string_view> operator*(const Parser<std::string_view> &parser)
 {
-    return Parser<bool>(std::function<bool(std::string_view &)>(
-        [=](std::string_view &stream) -> bool
-        {
-            if (stream.empty())
-            {
-                return false;
-            }
-
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<A, bool>::value)
+    return Parser<std::string_view>(std::function<std::optional<std::string_view>(std::string_view &stream)>
+            ([=](std::string_view &stream)-> std::optional<std::string_view>
             {
-                if (!left(stream_copy))
+                const std::string_view start(stream);
+                if (const CharSet *set = detail::charset_of(parser))
                 {
-                    return false;
+                    stream.remove_prefix(Scan::span_of(*set, stream));
                 }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
+                else
                 {
-                    return false;
+                    while (!stream.empty() && parser(stream).has_value());
                 }
-            }
+                return start.substr(0, start.length() - stream.length());
+            }));
+}
 
-            size_t pari_count = 1, left_length = stream.length() - stream_copy.length();
-            size_t temp = 0, right_length = 0;
-            while (pari_count > 0 && !stream_copy.empty())
+inline Parser<std::string_view> operator+(const Parser<std::string_view> &parser)
+{
+    return detail::with_first(Parser<std::string_view>(std::function<std::optional<std::string_view>(std::string_view &stream)>
+            ([=](std::string_view &stream)-> std::optional<std::string_view>
             {
-                temp = stream_copy.length();
-                if constexpr(std::is_same<C, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-                else
+                const std::string_view start(stream);
+                if (const CharSet *set = detail::charset_of(parser))
                 {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
+                    stream.remove_prefix(Scan::span_of(*set, stream));
                 }
-                
-                if constexpr(std::is_same<A, bool>::value)
+                else if (!stream.empty() && parser(stream).has_value())
                 {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
+                    while (!stream.empty() && parser(stream).has_value());
                 }
-                else
+                if (stream.length() == start.length())
                 {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
+                    return std::nullopt;
                 }
+                return start.substr(0, start.length() - stream.length());
+            })), detail::first_of(parser));
+}
 
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
+template <typename T>
+inline Parser<std::string_view> raw_p(const Parser<T> &parser)
+{
+    return detail::with_first(Parser<std::string_view>(std::function<std::optional<std::string_view>(std::string_view &)>(
+        [=](std::string_view &stream) -> std::optional<std::string_view>
+        {
+            const std::string_view start(stream);
+            if (detail::match(parser, stream))
             {
-                std::string_view stream_copy2 = stream.substr(0, stream.length() - stream_copy.length());
-                stream_copy2.remove_prefix(left_length);
-                stream_copy2.remove_suffix(right_length);
-                exp(stream_copy2);
-                if (stream_copy2.empty())
-                {
-                    stream.remove_prefix(stream.length() - stream_copy.length());
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
+                return start.substr(0, start.length() - stream.length());
             }
             else
             {
-                return false;
+                return std::nullopt;
             }
-        }));
+        })), detail::first_of(parser));
 }
 
-template <typename T>
-Parser<bool> repeat_p(const size_t times, const Parser<T> &parser)
+inline Parser<std::string_view> raw_p(const Parser<char> &parser)
 {
-    return Parser<bool>(std::function<bool(std::string_view &)>(
-        [=](std::string_view &stream) -> bool
+    Parser<std::string_view> result(std::function<std::optional<std::string_view>(std::string_view &)>(
+        [=](std::string_view &stream) -> std::optional<std::string_view>
         {
-            if (stream.empty())
-            {
-                return false;
-            }
-
-            size_t count = 0;
-            if constexpr(std::is_same<T, bool>::value)
+            const std::string_view start(stream);
+            if (parser(stream).has_value())
             {
-                for (size_t i = 0; i < times; ++i)
-                {
-                    if (parser(stream))
-                    {
-                        ++count;
-                    }
-                }
+                return start.substr(0, start.length() - stream.length());
             }
             else
             {
-                for (size_t i = 0; i < times; ++i)
-                {
-                    if (parser(stream).has_value())
-                    {
-                        ++count;
-                    }
-                }
+                return std::nullopt;
             }
-            return count == times;
         }));
+    result.charset = detail::charset_of(parser) == nullptr ? nullptr : parser.charset;
+    result.first = parser.first;
+    return result;
 }
 
-inline Parser<std::string> repeat_p(const size_t times, const Parser<char> &parser)
+template <typename T>
+inline Parser<std::string_view> raw_p(const std::reference_wrapper<Parser<T>> &parser)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
-        [=](std::string_view &stream) -> std::optional<std::string>
+    return Parser<std::string_view>(std::function<std::optional<std::string_view>(std::string_view &)>(
+        [=](std::string_view &stream) -> std::optional<std::string_view>
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-
-            std::vector<char> result;
-            std::optional<char> temp;
-            for (size_t i = 0; i < times; ++i)
-            {
-                temp = parser(stream);
-                if (temp.has_value())
-                {
-                    result.emplace_back(temp.value());
-                }
-            }
-
-            if (result.size() == times)
+            const std::string_view start(stream);
+            if (detail::match(parser, stream))
             {
-                return std::string(result.begin(), result.end());
+                return start.substr(0, start.length() - stream.length());
             }
             else
             {
@@ -974,40 +1503,50 @@ inline Parser<std::string> repeat_p(const size_t times, const Parser<char> &pars
         }));
 }
 
-inline Parser<std::string> repeat_p(const size_t times, const Parser<std::string> &parser)
+template <typename L, typename R>
+inline Parser<std::string_view> confix_view_p(const Parser<L> &left, const Parser<R> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
-        [=](std::string_view &stream) -> std::optional<std::string>
+    return Parser<std::string_view>(std::function<std::optional<std::string_view>(std::string_view &)>(
+        [=](std::string_view &stream) -> std::optional<std::string_view>
         {
-            if (stream.empty())
+            const std::optional<size_t> length = detail::confix_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
+            const std::string_view result = stream.substr(0, length.value());
+            stream.remove_prefix(length.value());
+            return result;
+        }));
+}
 
-            size_t count = 0;
-            std::string result;
-            std::optional<std::string> temp;
-            for (size_t i = 0; i < times; ++i)
-            {
-                temp = parser(stream);
-                if (temp.has_value())
-                {
-                    result.append(temp.value());
-                    ++count;
-                }
-            }
-
-            if (count == times)
-            {
-                return result;
-            }
-            else
+template <typename L, typename R>
+inline Parser<std::string_view> pair_view_p(const Parser<L> &left, const Parser<R> &right)
+{
+    return Parser<std::string_view>(std::function<std::optional<std::string_view>(std::string_view &)>(
+        [=](std::string_view &stream) -> std::optional<std::string_view>
+        {
+            const std::optional<size_t> length = detail::pair_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
+            const std::string_view result = stream.substr(0, length.value());
+            stream.remove_prefix(length.value());
+            return result;
         }));
 }
 
+inline Parser<std::string_view> repeat_p(const size_t min, const size_t max, const Parser<std::string_view> &parser)
+{
+    return detail::with_first(detail::repeat_range<std::string_view>(min, max, parser), min > 0 ? detail::first_of(parser) : nullptr);
+}
+
+inline Parser<std::string_view> repeat_p(const size_t times, const Parser<std::string_view> &parser)
+{
+    return repeat_p(times, times, parser);
+}
+
 
 // ref operators and functions
 // ref operator>>
@@ -1015,7 +1554,7 @@ inline Parser<std::string> repeat_p(const size_t times, const Parser<std::string
 template <typename L, typename R>
 Parser<bool> operator>>(const Parser<L> &left, const std::reference_wrapper<Parser<R>> &right)
 {
-    return Parser<bool>(std::function<bool(std::string_view &stream)>
+    return detail::with_first(Parser<bool>(std::function<bool(std::string_view &stream)>
             ([=](std::string_view &stream)-> bool
             {
                 std::string_view stream_copy(stream);
@@ -1051,7 +1590,7 @@ Parser<bool> operator>>(const Parser<L> &left, const std::reference_wrapper<Pars
 
                 stream.remove_prefix(stream.length() - stream_copy.length());
                 return true;
-            }));
+            })), detail::first_of(left));
 }
 
 template <typename L, typename R>
@@ -1140,7 +1679,7 @@ Parser<bool> operator>>(const std::reference_wrapper<Parser<L>> &left, const std
 
 inline Parser<std::string> operator>>(const Parser<char> &left, const std::reference_wrapper<Parser<char>> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 std::string_view stream_copy(stream);
@@ -1158,7 +1697,7 @@ inline Parser<std::string> operator>>(const Parser<char> &left, const std::refer
 
                 stream.remove_prefix(stream.length() - stream_copy.length());
                 return std::string({result_left.value(), result_right.value()});
-            }));
+            })), detail::first_of(left));
 }
 
 inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<char>> &left, const Parser<char> &right)
@@ -1209,7 +1748,7 @@ inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<char>>
 
 inline Parser<std::string> operator>>(const Parser<char> &left, const std::reference_wrapper<Parser<std::string>> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 std::string_view stream_copy(stream);
@@ -1228,7 +1767,7 @@ inline Parser<std::string> operator>>(const Parser<char> &left, const std::refer
                 stream.remove_prefix(stream.length() - stream_copy.length());
                 result_right.value().insert(result_right.value().begin(), result_left.value());
                 return result_right;
-            }));
+            })), detail::first_of(left));
 }
 
 inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<char>> &left, const Parser<std::string> &right)
@@ -1281,7 +1820,7 @@ inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<char>>
 
 inline Parser<std::string> operator>>(const Parser<std::string> &left, const std::reference_wrapper<Parser<char>> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 std::string_view stream_copy(stream);
@@ -1300,7 +1839,7 @@ inline Parser<std::string> operator>>(const Parser<std::string> &left, const std
                 stream.remove_prefix(stream.length() - stream_copy.length());
                 result_left.value().push_back(result_right.value());
                 return result_left;
-            }));
+            })), detail::first_of(left));
 }
 
 inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<std::string>> &left, const Parser<char> &right)
@@ -1353,7 +1892,7 @@ inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<std::s
 
 inline Parser<std::string> operator>>(const Parser<std::string> &left, const std::reference_wrapper<Parser<std::string>> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 std::string_view stream_copy(stream);
@@ -1370,8 +1909,9 @@ inline Parser<std::string> operator>>(const Parser<std::string> &left, const std
                 }
 
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return result_left.value() + result_right.value();
-            }));
+                result_left.value().append(result_right.value());
+                return result_left;
+            })), detail::first_of(left));
 }
 
 inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<std::string>> &left, const Parser<std::string> &right)
@@ -1393,7 +1933,8 @@ inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<std::s
                 }
 
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return result_left.value() + result_right.value();
+                result_left.value().append(result_right.value());
+                return result_left;
             }));
 }
 
@@ -1416,7 +1957,8 @@ inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<std::s
                 }
 
                 stream.remove_prefix(stream.length() - stream_copy.length());
-                return result_left.value() + result_right.value();
+                result_left.value().append(result_right.value());
+                return result_left;
             }));
 }
 
@@ -1425,76 +1967,19 @@ inline Parser<std::string> operator>>(const std::reference_wrapper<Parser<std::s
 template <typename L, typename R>
 Parser<bool> operator|(const Parser<L> &left, const std::reference_wrapper<Parser<R>> &right)
 {
-    return Parser<bool>(std::function<bool(std::string_view &stream)>
-            ([=](std::string_view &stream)-> bool
-            {
-                if constexpr(std::is_same<L, bool>::value && std::is_same<R, bool>::value)
-                {
-                    return left(stream) || right(stream);
-                }
-                else if constexpr(std::is_same<L, bool>::value)
-                {
-                    return left(stream) || right(stream).has_value();
-                }
-                else if constexpr(std::is_same<R, bool>::value)
-                {
-                    return left(stream).has_value() || right(stream);
-                }
-                else
-                {
-                    return left(stream).has_value() || right(stream).has_value();
-                }
-            }));
+    return detail::alternation_p<bool>(left, right);
 }
 
 template <typename L, typename R>
 Parser<bool> operator|(const std::reference_wrapper<Parser<L>> &left, const Parser<R> &right)
 {
-    return Parser<bool>(std::function<bool(std::string_view &stream)>
-            ([=](std::string_view &stream)-> bool
-            {
-                if constexpr(std::is_same<L, bool>::value && std::is_same<R, bool>::value)
-                {
-                    return left(stream) || right(stream);
-                }
-                else if constexpr(std::is_same<L, bool>::value)
-                {
-                    return left(stream) || right(stream).has_value();
-                }
-                else if constexpr(std::is_same<R, bool>::value)
-                {
-                    return left(stream).has_value() || right(stream);
-                }
-                else
-                {
-                    return left(stream).has_value() || right(stream).has_value();
-                }
-            }));
+    return detail::alternation_p<bool>(left, right);
 }
 
 template <typename L, typename R>
 Parser<bool> operator|(const std::reference_wrapper<Parser<L>> &left, const std::reference_wrapper<Parser<R>> &right)
 {
-    return Parser<bool>(std::function<bool(std::string_view &stream)>
-            ([=](std::string_view &stream)-> bool
-            {
-                if constexpr(std::is_same<L, bool>::value && std::is_same<R, bool>::value)
-                {
-                    return left(stream) || right(stream);
-                }
-                else if constexpr(std::is_same<L, bool>::value)
-                {
-                    return left(stream) || right(stream).has_value();
-                }
-                else if constexpr(std::is_same<R, bool>::value)
-                {
-                    return left(stream).has_value() || right(stream);
-                }
-                else
-                {
-                    return left(stream).has_value() || right(stream).has_value();
-                }
-            }));
+    return detail::alternation_p<bool>(left, right);
 }
 
 inline Parser<char> operator|(const Parser<char> &left, const std::reference_wrapper<Parser<char>> &right)
@@ -1502,11 +1987,16 @@ inline Parser<char> operator|(const Parser<char> &left, const std::reference_wra
     return Parser<char>(std::function<std::optional<char>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<char>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<char> result = left(stream);
                 if (result.has_value())
                 {
                     return result;
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
@@ -1519,11 +2009,16 @@ inline Parser<char> operator|(const std::reference_wrapper<Parser<char>> &left,
     return Parser<char>(std::function<std::optional<char>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<char>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<char> result = left(stream);
                 if (result.has_value())
                 {
                     return result;
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
@@ -1536,11 +2031,16 @@ inline Parser<char> operator|(const std::reference_wrapper<Parser<char>> &left,
     return Parser<char>(std::function<std::optional<char>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<char>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<char> result = left(stream);
                 if (result.has_value())
                 {
                     return result;
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
@@ -1553,11 +2053,16 @@ inline Parser<std::string> operator|(const Parser<std::string> &left, const std:
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<std::string> result_left = left(stream);
                 if (result_left.has_value())
                 {
                     return result_left;
                 }
+                if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 std::optional<char> result_right = right(stream);
                 if (result_right.has_value())
                 {
@@ -1572,11 +2077,16 @@ inline Parser<std::string> operator|(const std::reference_wrapper<Parser<std::st
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<std::string> result_left = left(stream);
                 if (result_left.has_value())
                 {
                     return result_left;
                 }
+                if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 std::optional<char> result_right = right(stream);
                 if (result_right.has_value())
                 {
@@ -1591,11 +2101,16 @@ inline Parser<std::string> operator|(const std::reference_wrapper<Parser<std::st
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<std::string> result_left = left(stream);
                 if (result_left.has_value())
                 {
                     return result_left;
                 }
+                if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 std::optional<char> result_right = right(stream);
                 if (result_right.has_value())
                 {
@@ -1610,11 +2125,16 @@ inline Parser<std::string> operator|(const Parser<char> &left, const std::refere
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<char> result_left = left(stream);
                 if (result_left.has_value())
                 {
                     return std::string({result_left.value()});
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
@@ -1627,11 +2147,16 @@ inline Parser<std::string> operator|(const std::reference_wrapper<Parser<char>>
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<char> result_left = left(stream);
                 if (result_left.has_value())
                 {
                     return std::string({result_left.value()});
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
@@ -1644,11 +2169,16 @@ inline Parser<std::string> operator|(const std::reference_wrapper<Parser<char>>
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<char> result_left = left(stream);
                 if (result_left.has_value())
                 {
                     return std::string({result_left.value()});
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
@@ -1661,11 +2191,16 @@ inline Parser<std::string> operator|(const Parser<std::string> &left, const std:
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<std::string> result = left(stream);
                 if (result.has_value())
                 {
                     return result;
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
@@ -1678,11 +2213,16 @@ inline Parser<std::string> operator|(const std::reference_wrapper<Parser<std::st
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<std::string> result = left(stream);
                 if (result.has_value())
                 {
                     return result;
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
@@ -1695,11 +2235,16 @@ inline Parser<std::string> operator|(const std::reference_wrapper<Parser<std::st
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
+                const size_t passed = Cut::current().passed;
                 std::optional<std::string> result = left(stream);
                 if (result.has_value())
                 {
                     return result;
                 }
+                else if (Cut::current().passed != passed)
+                {
+                    return std::nullopt;
+                }
                 else
                 {
                     return right(stream);
@@ -1719,8 +2264,8 @@ Parser<bool> operator!(const std::reference_wrapper<Parser<T>> &parser)
                 {
                     return true;
                 }
-                parser(stream);
-                return true;
+                const size_t passed = Cut::current().passed;
+                return detail::match(parser, stream) || Cut::current().passed == passed;
             }));
 }
 
@@ -1736,15 +2281,7 @@ Parser<bool> operator*(const std::reference_wrapper<Parser<T>> &parser)
                 {
                     return true;
                 }
-                if constexpr(std::is_same<T, bool>::value)
-                {
-                    while (parser(stream));
-                }
-                else
-                {
-                    while (parser(stream).has_value());
-                }
-                return true;
+                return detail::repeat(parser, stream);
             }));
 }
 
@@ -1757,14 +2294,21 @@ inline Parser<std::string> operator*(const std::reference_wrapper<Parser<char>>
                 {
                     return std::string();
                 }
+                if (const CharSet *set = detail::charset_of(parser))
+                {
+                    const size_t length = Scan::span_of(*set, stream);
+                    std::string result(stream.substr(0, length));
+                    stream.remove_prefix(length);
+                    return result;
+                }
                 std::optional<char> temp = parser(stream);
-                std::vector<char> result;
+                std::string result;
                 while (temp.has_value())
                 {
                     result.push_back(temp.value());
                     temp = parser(stream);
                 }
-                return std::string(result.begin(), result.end());
+                return result;
             }));
 }
 
@@ -1781,7 +2325,14 @@ inline Parser<std::string> operator*(const std::reference_wrapper<Parser<std::st
                 std::string result;
                 while (temp.has_value())
                 {
-                    result.append(temp.value());
+                    if (result.empty())
+                    {
+                        result = std::move(temp.value());
+                    }
+                    else
+                    {
+                        result.append(temp.value());
+                    }
                     temp = parser(stream);
                 }
                 return result;
@@ -1800,30 +2351,13 @@ Parser<bool> operator+(const std::reference_wrapper<Parser<T>> &parser)
                 {
                     return false;
                 }
-                if constexpr(std::is_same<T, bool>::value)
-                {
-                    if (parser(stream))
-                    {
-                        while (parser(stream));
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
-                }
-                else
+                std::string_view stream_copy(stream);
+                if (!detail::match(parser, stream_copy) || !detail::repeat(parser, stream_copy))
                 {
-                    if (parser(stream).has_value())
-                    {
-                        while (parser(stream).has_value());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    return false;
                 }
+                stream = stream_copy;
+                return true;
             }));
 }
 
@@ -1836,8 +2370,19 @@ inline Parser<std::string> operator+(const std::reference_wrapper<Parser<char>>
                 {
                     return std::nullopt;
                 }
+                if (const CharSet *set = detail::charset_of(parser))
+                {
+                    const size_t length = Scan::span_of(*set, stream);
+                    if (length == 0)
+                    {
+                        return std::nullopt;
+                    }
+                    std::string result(stream.substr(0, length));
+                    stream.remove_prefix(length);
+                    return result;
+                }
                 std::optional<char> temp = parser(stream);
-                std::vector<char> result;
+                std::string result;
                 while (temp.has_value())
                 {
                     result.push_back(temp.value());
@@ -1849,7 +2394,7 @@ inline Parser<std::string> operator+(const std::reference_wrapper<Parser<char>>
                 }
                 else
                 {
-                    return std::string(result.begin(), result.end());
+                    return result;
                 }
             }));
 }
@@ -1867,11 +2412,18 @@ inline Parser<std::string> operator+(const std::reference_wrapper<Parser<std::st
                 std::string result;
                 while (temp.has_value())
                 {
-                    result.append(temp.value());
-                    temp = parser(stream);
-                }
-                if (result.empty())
-                {
+                    if (result.empty())
+                    {
+                        result = std::move(temp.value());
+                    }
+                    else
+                    {
+                        result.append(temp.value());
+                    }
+                    temp = parser(stream);
+                }
+                if (result.empty())
+                {
                     return std::nullopt;
                 }
                 else
@@ -1893,22 +2445,15 @@ Parser<std::string> operator~(const std::reference_wrapper<Parser<T>> &parser)
                 {
                     return std::nullopt;
                 }
-                std::optional<T> temp = parser(stream);
-                std::vector<char> result;
-                while (!temp.has_value() && !stream.empty())
-                {
-                    result.emplace_back(stream.front());
-                    stream.remove_prefix(1);
-                    temp = parser(stream);
-                }
-                if (result.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(parser, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
-                else
-                {
-                    return std::string(result.cbegin(), result.cend());
-                }
+                std::string result(stream.substr(0, length));
+                stream.remove_prefix(length + matched);
+                return result;
             }));
 }
 
@@ -1917,7 +2462,7 @@ Parser<std::string> operator~(const std::reference_wrapper<Parser<T>> &parser)
 template <typename L, typename R>
 Parser<bool> operator-(const Parser<L> &left, const std::reference_wrapper<Parser<R>> &right)
 {
-    return Parser<bool>(std::function<bool(std::string_view &stream)>
+    return detail::with_first(Parser<bool>(std::function<bool(std::string_view &stream)>
             ([=](std::string_view &stream)-> bool
             {
                 if (stream.empty())
@@ -1925,60 +2470,24 @@ Parser<bool> operator-(const Parser<L> &left, const std::reference_wrapper<Parse
                     return false;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return false;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
-                if constexpr(std::is_same<L, bool>::value)
+                std::string_view sub_stream = stream.substr(0, length);
+                if (detail::match(left, sub_stream))
                 {
-                    if (left(sub_stream))
-                    {
-                        stream.remove_prefix(start - sub_stream.length());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    stream.remove_prefix(length - sub_stream.length());
+                    return true;
                 }
                 else
                 {
-                    if (left(sub_stream).has_value())
-                    {
-                        stream.remove_prefix(start - sub_stream.length());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    return false;
                 }
-            }));
+            })), detail::first_of(left));
 }
 
 template <typename L, typename R>
@@ -1992,58 +2501,22 @@ Parser<bool> operator-(const std::reference_wrapper<Parser<L>> &left, const Pars
                     return false;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return false;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
-                if constexpr(std::is_same<L, bool>::value)
+                std::string_view sub_stream = stream.substr(0, length);
+                if (detail::match(left, sub_stream))
                 {
-                    if (left(sub_stream))
-                    {
-                        stream.remove_prefix(start - sub_stream.length());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    stream.remove_prefix(length - sub_stream.length());
+                    return true;
                 }
                 else
                 {
-                    if (left(sub_stream).has_value())
-                    {
-                        stream.remove_prefix(start - sub_stream.length());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    return false;
                 }
             }));
 }
@@ -2059,58 +2532,22 @@ Parser<bool> operator-(const std::reference_wrapper<Parser<L>> &left, const std:
                     return false;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return false;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
-                if constexpr(std::is_same<L, bool>::value)
+                std::string_view sub_stream = stream.substr(0, length);
+                if (detail::match(left, sub_stream))
                 {
-                    if (left(sub_stream))
-                    {
-                        stream.remove_prefix(start - sub_stream.length());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    stream.remove_prefix(length - sub_stream.length());
+                    return true;
                 }
                 else
                 {
-                    if (left(sub_stream).has_value())
-                    {
-                        stream.remove_prefix(start - sub_stream.length());
-                        return true;
-                    }
-                    else
-                    {
-                        return false;
-                    }
+                    return false;
                 }
             }));
 }
@@ -2118,7 +2555,7 @@ Parser<bool> operator-(const std::reference_wrapper<Parser<L>> &left, const std:
 template <typename R>
 Parser<char> operator-(const Parser<char> &left, const std::reference_wrapper<Parser<R>> &right)
 {
-    return Parser<char>(std::function<std::optional<char>(std::string_view &stream)>
+    return detail::with_first(Parser<char>(std::function<std::optional<char>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<char>
             {
                 if (stream.empty())
@@ -2126,46 +2563,25 @@ Parser<char> operator-(const Parser<char> &left, const std::reference_wrapper<Pa
                     return std::nullopt;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
+                std::string_view sub_stream = stream.substr(0, length);
                 std::optional<char> result = left(sub_stream);
                 if (result.has_value())
                 {
-                    stream.remove_prefix(start - sub_stream.length());
+                    stream.remove_prefix(length - sub_stream.length());
                     return result;
                 }
                 else
                 {
                     return std::nullopt;
                 }
-            }));
+            })), detail::first_of(left));
 }
 
 template <typename R>
@@ -2179,39 +2595,18 @@ Parser<char> operator-(const std::reference_wrapper<Parser<char>> &left, const P
                     return std::nullopt;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
+                std::string_view sub_stream = stream.substr(0, length);
                 std::optional<char> result = left(sub_stream);
                 if (result.has_value())
                 {
-                    stream.remove_prefix(start - sub_stream.length());
+                    stream.remove_prefix(length - sub_stream.length());
                     return result;
                 }
                 else
@@ -2232,39 +2627,18 @@ Parser<char> operator-(const std::reference_wrapper<Parser<char>> &left, const s
                     return std::nullopt;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
+                std::string_view sub_stream = stream.substr(0, length);
                 std::optional<char> result = left(sub_stream);
                 if (result.has_value())
                 {
-                    stream.remove_prefix(start - sub_stream.length());
+                    stream.remove_prefix(length - sub_stream.length());
                     return result;
                 }
                 else
@@ -2277,7 +2651,7 @@ Parser<char> operator-(const std::reference_wrapper<Parser<char>> &left, const s
 template <typename R>
 Parser<std::string> operator-(const Parser<std::string> &left, const std::reference_wrapper<Parser<R>> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &stream)>
             ([=](std::string_view &stream)-> std::optional<std::string>
             {
                 if (stream.empty())
@@ -2285,46 +2659,25 @@ Parser<std::string> operator-(const Parser<std::string> &left, const std::refere
                     return std::nullopt;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
+                std::string_view sub_stream = stream.substr(0, length);
                 std::optional<std::string> result = left(sub_stream);
                 if (result.has_value())
                 {
-                    stream.remove_prefix(start - sub_stream.length());
+                    stream.remove_prefix(length - sub_stream.length());
                     return result;
                 }
                 else
                 {
                     return std::nullopt;
                 }
-            }));
+            })), detail::first_of(left));
 }
 
 template <typename R>
@@ -2338,39 +2691,18 @@ Parser<std::string> operator-(const std::reference_wrapper<Parser<std::string>>
                     return std::nullopt;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
+                std::string_view sub_stream = stream.substr(0, length);
                 std::optional<std::string> result = left(sub_stream);
                 if (result.has_value())
                 {
-                    stream.remove_prefix(start - sub_stream.length());
+                    stream.remove_prefix(length - sub_stream.length());
                     return result;
                 }
                 else
@@ -2391,39 +2723,18 @@ Parser<std::string> operator-(const std::reference_wrapper<Parser<std::string>>
                     return std::nullopt;
                 }
 
-                std::string_view stream_copy(stream);
-                std::vector<char> temp_string;
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    bool temp = right(stream_copy);
-                    while (!temp && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                else
-                {
-                    std::optional<R> temp = right(stream_copy);
-                    while (!temp.has_value() && !stream_copy.empty())
-                    {
-                        temp_string.emplace_back(stream_copy.front());
-                        stream_copy.remove_prefix(1);
-                        temp = right(stream_copy);
-                    }
-                }
-                if (temp_string.empty())
+                size_t matched = 0;
+                const size_t length = detail::until_length(right, stream, matched);
+                if (length == 0)
                 {
                     return std::nullopt;
                 }
 
-                std::string_view sub_stream(&temp_string.front(), temp_string.size());
-                const size_t start = sub_stream.length();
+                std::string_view sub_stream = stream.substr(0, length);
                 std::optional<std::string> result = left(sub_stream);
                 if (result.has_value())
                 {
-                    stream.remove_prefix(start - sub_stream.length());
+                    stream.remove_prefix(length - sub_stream.length());
                     return result;
                 }
                 else
@@ -2483,118 +2794,32 @@ inline Parser<std::string> confix_p(const std::reference_wrapper<Parser<L>> &lef
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<std::string>
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<L, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return std::nullopt;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return std::nullopt;
-                }
-            }
-
-            std::vector<char> temp_string;
-            if constexpr(std::is_same<R, bool>::value)
-            {
-                bool temp = right(stream_copy);
-                while (!temp && !stream_copy.empty())
-                {
-                    temp_string.emplace_back(stream_copy.front());
-                    stream_copy.remove_prefix(1);
-                    temp = right(stream_copy);
-                }
-            }
-            else
-            {
-                std::optional<R> temp = right(stream_copy);
-                while (!temp.has_value() && !stream_copy.empty())
-                {
-                    temp_string.emplace_back(stream_copy.front());
-                    stream_copy.remove_prefix(1);
-                    temp = right(stream_copy);
-                }
-            }
-            if (temp_string.empty())
+            const std::optional<size_t> length = detail::confix_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
-            else
-            {
-                std::string result(stream.begin(), stream.begin() + stream.length() - stream_copy.length());
-                stream.remove_prefix(stream.length() - stream_copy.length());
-                return result;
-            }
+            std::string result(stream.substr(0, length.value()));
+            stream.remove_prefix(length.value());
+            return result;
         }));
 }
 
 template <typename L, typename R>
 inline Parser<std::string> confix_p(const Parser<L> &left, const std::reference_wrapper<Parser<R>> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<std::string>
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<L, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return std::nullopt;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return std::nullopt;
-                }
-            }
-
-            std::vector<char> temp_string;
-            if constexpr(std::is_same<R, bool>::value)
-            {
-                bool temp = right(stream_copy);
-                while (!temp && !stream_copy.empty())
-                {
-                    temp_string.emplace_back(stream_copy.front());
-                    stream_copy.remove_prefix(1);
-                    temp = right(stream_copy);
-                }
-            }
-            else
-            {
-                std::optional<R> temp = right(stream_copy);
-                while (!temp.has_value() && !stream_copy.empty())
-                {
-                    temp_string.emplace_back(stream_copy.front());
-                    stream_copy.remove_prefix(1);
-                    temp = right(stream_copy);
-                }
-            }
-            if (temp_string.empty())
+            const std::optional<size_t> length = detail::confix_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
-            else
-            {
-                std::string result(stream.begin(), stream.begin() + stream.length() - stream_copy.length());
-                stream.remove_prefix(stream.length() - stream_copy.length());
-                return result;
-            }
-        }));
+            std::string result(stream.substr(0, length.value()));
+            stream.remove_prefix(length.value());
+            return result;
+        })), detail::first_of(left));
 }
 
 template <typename L, typename R>
@@ -2603,59 +2828,16 @@ inline Parser<std::string> confix_p(const std::reference_wrapper<Parser<L>> &lef
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<std::string>
         {
-            if (stream.empty())
+            const std::optional<size_t> length = detail::confix_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<L, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return std::nullopt;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return std::nullopt;
-                }
-            }
-
-            std::vector<char> temp_string;
-            if constexpr(std::is_same<R, bool>::value)
-            {
-                bool temp = right(stream_copy);
-                while (!temp && !stream_copy.empty())
-                {
-                    temp_string.emplace_back(stream_copy.front());
-                    stream_copy.remove_prefix(1);
-                    temp = right(stream_copy);
-                }
-            }
-            else
-            {
-                std::optional<R> temp = right(stream_copy);
-                while (!temp.has_value() && !stream_copy.empty())
-                {
-                    temp_string.emplace_back(stream_copy.front());
-                    stream_copy.remove_prefix(1);
-                    temp = right(stream_copy);
-                }
-            }
-            if (temp_string.empty())
-            {
-                return std::nullopt;
-            }
-            else
-            {
-                std::string result(stream.begin(), stream.begin() + stream.length() - stream_copy.length());
-                stream.remove_prefix(stream.length() - stream_copy.length());
-                return result;
-            }
-        }));
-}
+            std::string result(stream.substr(0, length.value()));
+            stream.remove_prefix(length.value());
+            return result;
+        }));
+}
 
 // ref list_p
 
@@ -2677,84 +2859,64 @@ inline auto list_p(const std::reference_wrapper<Parser<A>> &value, const std::re
     return value >> *(exp >> value);
 }
 
+// ref sep_by_p
+
+template <typename A, typename B>
+inline Parser<bool> sep_by_p(const Parser<A> &value, const std::reference_wrapper<Parser<B>> &sep)
+{
+    return detail::with_first(detail::sep_by_parser(value, sep), detail::first_of(value));
+}
+
+template <typename A, typename B>
+inline Parser<bool> sep_by_p(const std::reference_wrapper<Parser<A>> &value, const Parser<B> &sep)
+{
+    return detail::sep_by_parser(value, sep);
+}
+
+template <typename A, typename B>
+inline Parser<bool> sep_by_p(const std::reference_wrapper<Parser<A>> &value, const std::reference_wrapper<Parser<B>> &sep)
+{
+    return detail::sep_by_parser(value, sep);
+}
+
+template <typename T, typename B, typename C>
+inline Parser<bool> sep_by_p(const Parser<T> &value, const std::reference_wrapper<Parser<B>> &sep,
+    std::vector<T> C::*output, const size_t capacity = 0, C *object = nullptr)
+{
+    return detail::with_first(detail::sep_by_parser(value, sep, output, capacity, object), detail::first_of(value));
+}
+
+template <typename T, typename B, typename C>
+inline Parser<bool> sep_by_p(const std::reference_wrapper<Parser<T>> &value, const Parser<B> &sep,
+    std::vector<T> C::*output, const size_t capacity = 0, C *object = nullptr)
+{
+    return detail::sep_by_parser(value, sep, output, capacity, object);
+}
+
+template <typename T, typename B, typename C>
+inline Parser<bool> sep_by_p(const std::reference_wrapper<Parser<T>> &value, const std::reference_wrapper<Parser<B>> &sep,
+    std::vector<T> C::*output, const size_t capacity = 0, C *object = nullptr)
+{
+    return detail::sep_by_parser(value, sep, output, capacity, object);
+}
+
 // ref pair_p
 
 template <typename L, typename R>
 Parser<std::string> pair_p(const Parser<L> &left, const std::reference_wrapper<Parser<R>> &right)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
+    return detail::with_first(Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<std::string>
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<L, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return std::nullopt;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return std::nullopt;
-                }
-            }
-
-            size_t pari_count = 1;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        continue;
-                    }
-                }
-                
-                if constexpr(std::is_same<L, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string result(stream.begin(), stream.begin() + stream.length() - stream_copy.length());
-                stream.remove_prefix(stream.length() - stream_copy.length());
-                return result;
-            }
-            else
+            const std::optional<size_t> length = detail::pair_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
-        }));
+            std::string result(stream.substr(0, length.value()));
+            stream.remove_prefix(length.value());
+            return result;
+        })), detail::first_of(left));
 }
 
 template <typename L, typename R>
@@ -2763,75 +2925,14 @@ Parser<std::string> pair_p(const std::reference_wrapper<Parser<L>> &left, const
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<std::string>
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<L, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return std::nullopt;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return std::nullopt;
-                }
-            }
-
-            size_t pari_count = 1;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        continue;
-                    }
-                }
-
-                if constexpr(std::is_same<L, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string result(stream.begin(), stream.begin() + stream.length() - stream_copy.length());
-                stream.remove_prefix(stream.length() - stream_copy.length());
-                return result;
-            }
-            else
+            const std::optional<size_t> length = detail::pair_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
+            std::string result(stream.substr(0, length.value()));
+            stream.remove_prefix(length.value());
+            return result;
         }));
 }
 
@@ -2841,829 +2942,150 @@ Parser<std::string> pair_p(const std::reference_wrapper<Parser<L>> &left, const
     return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
         [=](std::string_view &stream) -> std::optional<std::string>
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<L, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return std::nullopt;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return std::nullopt;
-                }
-            }
-
-            size_t pari_count = 1;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                if constexpr(std::is_same<R, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        continue;
-                    }
-                }
-
-                if constexpr(std::is_same<L, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string result(stream.begin(), stream.begin() + stream.length() - stream_copy.length());
-                stream.remove_prefix(stream.length() - stream_copy.length());
-                return result;
-            }
-            else
+            const std::optional<size_t> length = detail::pair_length(left, right, stream);
+            if (!length.has_value())
             {
                 return std::nullopt;
             }
+            std::string result(stream.substr(0, length.value()));
+            stream.remove_prefix(length.value());
+            return result;
         }));
 }
 
 template <typename A, typename B, typename C>
 Parser<bool> pair_p(const Parser<A> &left, const Parser<B> &exp, const std::reference_wrapper<Parser<C>> &right)
 {
-    return Parser<bool>(std::function<bool(std::string_view &)>(
+    return detail::with_first(Parser<bool>(std::function<bool(std::string_view &)>(
         [=](std::string_view &stream) -> bool
         {
-            if (stream.empty())
-            {
-                return false;
-            }
+            return detail::pair_parse(left, exp, right, stream);
+        })), detail::first_of(left));
+}
 
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<A, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return false;
-                }
-            }
+template <typename A, typename B, typename C>
+Parser<bool> pair_p(const Parser<A> &left, const std::reference_wrapper<Parser<B>> &exp, const Parser<C> &right)
+{
+    return detail::with_first(Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
+        {
+            return detail::pair_parse(left, exp, right, stream);
+        })), detail::first_of(left));
+}
 
-            size_t pari_count = 1, left_length = stream.length() - stream_copy.length();
-            size_t temp = 0, right_length = 0;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                temp = stream_copy.length();
-                if constexpr(std::is_same<C, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
+template <typename A, typename B, typename C>
+Parser<bool> pair_p(const std::reference_wrapper<Parser<A>> &left, const Parser<B> &exp, const Parser<C> &right)
+{
+    return Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
+        {
+            return detail::pair_parse(left, exp, right, stream);
+        }));
+}
 
-                if constexpr(std::is_same<A, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
+template <typename A, typename B, typename C>
+Parser<bool> pair_p(const Parser<A> &left, const std::reference_wrapper<Parser<B>> &exp, const std::reference_wrapper<Parser<C>> &right)
+{
+    return detail::with_first(Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
+        {
+            return detail::pair_parse(left, exp, right, stream);
+        })), detail::first_of(left));
+}
 
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string_view stream_copy2 = stream.substr(0, stream.length() - stream_copy.length());
-                stream_copy2.remove_prefix(left_length);
-                stream_copy2.remove_suffix(right_length);
-                exp(stream_copy2);
-                if (stream_copy2.empty())
-                {
-                    stream.remove_prefix(stream.length() - stream_copy.length());
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                return false;
-            }
+template <typename A, typename B, typename C>
+Parser<bool> pair_p(const std::reference_wrapper<Parser<A>> &left, const Parser<B> &exp, const std::reference_wrapper<Parser<C>> &right)
+{
+    return Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
+        {
+            return detail::pair_parse(left, exp, right, stream);
         }));
 }
 
 template <typename A, typename B, typename C>
-Parser<bool> pair_p(const Parser<A> &left, const std::reference_wrapper<Parser<B>> &exp, const Parser<C> &right)
+Parser<bool> pair_p(const std::reference_wrapper<Parser<A>> &left, const std::reference_wrapper<Parser<B>> &exp, const Parser<C> &right)
 {
     return Parser<bool>(std::function<bool(std::string_view &)>(
         [=](std::string_view &stream) -> bool
         {
-            if (stream.empty())
-            {
-                return false;
-            }
-
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<A, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return false;
-                }
-            }
-
-            size_t pari_count = 1, left_length = stream.length() - stream_copy.length();
-            size_t temp = 0, right_length = 0;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                temp = stream_copy.length();
-                if constexpr(std::is_same<C, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-
-                if constexpr(std::is_same<A, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string_view stream_copy2 = stream.substr(0, stream.length() - stream_copy.length());
-                stream_copy2.remove_prefix(left_length);
-                stream_copy2.remove_suffix(right_length);
-                exp(stream_copy2);
-                if (stream_copy2.empty())
-                {
-                    stream.remove_prefix(stream.length() - stream_copy.length());
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                return false;
-            }
-        }));
-}
+            return detail::pair_parse(left, exp, right, stream);
+        }));
+}
 
 template <typename A, typename B, typename C>
-Parser<bool> pair_p(const std::reference_wrapper<Parser<A>> &left, const Parser<B> &exp, const Parser<C> &right)
+Parser<bool> pair_p(const std::reference_wrapper<Parser<A>> &left, const std::reference_wrapper<Parser<B>> &exp, const std::reference_wrapper<Parser<C>> &right)
 {
     return Parser<bool>(std::function<bool(std::string_view &)>(
         [=](std::string_view &stream) -> bool
         {
-            if (stream.empty())
-            {
-                return false;
-            }
-
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<A, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return false;
-                }
-            }
-
-            size_t pari_count = 1, left_length = stream.length() - stream_copy.length();
-            size_t temp = 0, right_length = 0;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                temp = stream_copy.length();
-                if constexpr(std::is_same<C, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-
-                if constexpr(std::is_same<A, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string_view stream_copy2 = stream.substr(0, stream.length() - stream_copy.length());
-                stream_copy2.remove_prefix(left_length);
-                stream_copy2.remove_suffix(right_length);
-                exp(stream_copy2);
-                if (stream_copy2.empty())
-                {
-                    stream.remove_prefix(stream.length() - stream_copy.length());
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                return false;
-            }
+            return detail::pair_parse(left, exp, right, stream);
         }));
 }
 
-template <typename A, typename B, typename C>
-Parser<bool> pair_p(const Parser<A> &left, const std::reference_wrapper<Parser<B>> &exp, const std::reference_wrapper<Parser<C>> &right)
-{
-    return Parser<bool>(std::function<bool(std::string_view &)>(
-        [=](std::string_view &stream) -> bool
-        {
-            if (stream.empty())
-            {
-                return false;
-            }
-
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<A, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return false;
-                }
-            }
-
-            size_t pari_count = 1, left_length = stream.length() - stream_copy.length();
-            size_t temp = 0, right_length = 0;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                temp = stream_copy.length();
-                if constexpr(std::is_same<C, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-
-                if constexpr(std::is_same<A, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
+// ref repeat_p
 
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string_view stream_copy2 = stream.substr(0, stream.length() - stream_copy.length());
-                stream_copy2.remove_prefix(left_length);
-                stream_copy2.remove_suffix(right_length);
-                exp(stream_copy2);
-                if (stream_copy2.empty())
-                {
-                    stream.remove_prefix(stream.length() - stream_copy.length());
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                return false;
-            }
-        }));
+template <typename T>
+Parser<bool> repeat_p(const size_t min, const size_t max, const std::reference_wrapper<Parser<T>> &parser)
+{
+    return detail::repeat_range<bool>(min, max, parser);
 }
 
-template <typename A, typename B, typename C>
-Parser<bool> pair_p(const std::reference_wrapper<Parser<A>> &left, const Parser<B> &exp, const std::reference_wrapper<Parser<C>> &right)
+template <typename T>
+Parser<bool> repeat_p(const size_t times, const std::reference_wrapper<Parser<T>> &parser)
 {
-    return Parser<bool>(std::function<bool(std::string_view &)>(
-        [=](std::string_view &stream) -> bool
-        {
-            if (stream.empty())
-            {
-                return false;
-            }
-
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<A, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return false;
-                }
-            }
-
-            size_t pari_count = 1, left_length = stream.length() - stream_copy.length();
-            size_t temp = 0, right_length = 0;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                temp = stream_copy.length();
-                if constexpr(std::is_same<C, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-
-                if constexpr(std::is_same<A, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string_view stream_copy2 = stream.substr(0, stream.length() - stream_copy.length());
-                stream_copy2.remove_prefix(left_length);
-                stream_copy2.remove_suffix(right_length);
-                exp(stream_copy2);
-                if (stream_copy2.empty())
-                {
-                    stream.remove_prefix(stream.length() - stream_copy.length());
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                return false;
-            }
-        }));
+    return repeat_p(times, times, parser);
 }
 
-template <typename A, typename B, typename C>
-Parser<bool> pair_p(const std::reference_wrapper<Parser<A>> &left, const std::reference_wrapper<Parser<B>> &exp, const Parser<C> &right)
+inline Parser<std::string> repeat_p(const size_t min, const size_t max, const std::reference_wrapper<Parser<char>> &parser)
 {
-    return Parser<bool>(std::function<bool(std::string_view &)>(
-        [=](std::string_view &stream) -> bool
-        {
-            if (stream.empty())
-            {
-                return false;
-            }
-
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<A, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return false;
-                }
-            }
-
-            size_t pari_count = 1, left_length = stream.length() - stream_copy.length();
-            size_t temp = 0, right_length = 0;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                temp = stream_copy.length();
-                if constexpr(std::is_same<C, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-
-                if constexpr(std::is_same<A, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string_view stream_copy2 = stream.substr(0, stream.length() - stream_copy.length());
-                stream_copy2.remove_prefix(left_length);
-                stream_copy2.remove_suffix(right_length);
-                exp(stream_copy2);
-                if (stream_copy2.empty())
-                {
-                    stream.remove_prefix(stream.length() - stream_copy.length());
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                return false;
-            }
-        }));
+    return detail::repeat_range<std::string>(min, max, parser);
 }
 
-template <typename A, typename B, typename C>
-Parser<bool> pair_p(const std::reference_wrapper<Parser<A>> &left, const std::reference_wrapper<Parser<B>> &exp, const std::reference_wrapper<Parser<C>> &right)
+inline Parser<std::string> repeat_p(const size_t times, const std::reference_wrapper<Parser<char>> &parser)
 {
-    return Parser<bool>(std::function<bool(std::string_view &)>(
-        [=](std::string_view &stream) -> bool
-        {
-            if (stream.empty())
-            {
-                return false;
-            }
-
-            std::string_view stream_copy(stream);
-            if constexpr(std::is_same<A, bool>::value)
-            {
-                if (!left(stream_copy))
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                if (!left(stream_copy).has_value())
-                {
-                    return false;
-                }
-            }
-
-            size_t pari_count = 1, left_length = stream.length() - stream_copy.length();
-            size_t temp = 0, right_length = 0;
-            while (pari_count > 0 && !stream_copy.empty())
-            {
-                temp = stream_copy.length();
-                if constexpr(std::is_same<C, bool>::value)
-                {
-                    if (right(stream_copy))
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (right(stream_copy).has_value())
-                    {
-                        --pari_count;
-                        right_length = temp - stream_copy.length();
-                        continue;
-                    }
-                }
+    return repeat_p(times, times, parser);
+}
 
-                if constexpr(std::is_same<A, bool>::value)
-                {
-                    if (left(stream_copy))
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
-                else
-                {
-                    if (left(stream_copy).has_value())
-                    {
-                        ++pari_count;
-                        continue;
-                    }
-                }
+inline Parser<std::string> repeat_p(const size_t min, const size_t max, const std::reference_wrapper<Parser<std::string>> &parser)
+{
+    return detail::repeat_range<std::string>(min, max, parser);
+}
 
-                stream_copy.remove_prefix(1);
-            }
-            if (pari_count == 0)
-            {
-                std::string_view stream_copy2 = stream.substr(0, stream.length() - stream_copy.length());
-                stream_copy2.remove_prefix(left_length);
-                stream_copy2.remove_suffix(right_length);
-                exp(stream_copy2);
-                if (stream_copy2.empty())
-                {
-                    stream.remove_prefix(stream.length() - stream_copy.length());
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
-            }
-            else
-            {
-                return false;
-            }
-        }));
+inline Parser<std::string> repeat_p(const size_t times, const std::reference_wrapper<Parser<std::string>> &parser)
+{
+    return repeat_p(times, times, parser);
 }
 
-// ref repeat_p
+// ref recover_p
 
-template <typename T>
-Parser<bool> repeat_p(const size_t times, const std::reference_wrapper<Parser<T>> &parser)
+template <typename R, typename S>
+Parser<bool> recover_p(const std::reference_wrapper<Parser<R>> &record, const Parser<S> &sync)
 {
+    const std::shared_ptr<const CharSet> skip = detail::skip_of(sync);
     return Parser<bool>(std::function<bool(std::string_view &)>(
         [=](std::string_view &stream) -> bool
         {
-            if (stream.empty())
-            {
-                return false;
-            }
-
-            size_t count = 0;
-            if constexpr(std::is_same<T, bool>::value)
-            {
-                for (size_t i = 0; i < times; ++i)
-                {
-                    if (parser(stream))
-                    {
-                        ++count;
-                    }
-                }
-            }
-            else
-            {
-                for (size_t i = 0; i < times; ++i)
-                {
-                    if (parser(stream).has_value())
-                    {
-                        ++count;
-                    }
-                }
-            }
-            return count == times;
+            return detail::recover(record, sync, skip.get(), stream);
         }));
 }
 
-inline Parser<std::string> repeat_p(const size_t times, const std::reference_wrapper<Parser<char>> &parser)
+template <typename R, typename S>
+Parser<bool> recover_p(const Parser<R> &record, const std::reference_wrapper<Parser<S>> &sync)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
-        [=](std::string_view &stream) -> std::optional<std::string>
+    return Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-
-            std::vector<char> result;
-            std::optional<char> temp;
-            for (size_t i = 0; i < times; ++i)
-            {
-                temp = parser(stream);
-                if (temp.has_value())
-                {
-                    result.emplace_back(temp.value());
-                }
-            }
-
-            if (result.size() == times)
-            {
-                return std::string(result.begin(), result.end());
-            }
-            else
-            {
-                return std::nullopt;
-            }
+            return detail::recover(record, sync, nullptr, stream);
         }));
 }
 
-inline Parser<std::string> repeat_p(const size_t times, const std::reference_wrapper<Parser<std::string>> &parser)
+template <typename R, typename S>
+Parser<bool> recover_p(const std::reference_wrapper<Parser<R>> &record, const std::reference_wrapper<Parser<S>> &sync)
 {
-    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
-        [=](std::string_view &stream) -> std::optional<std::string>
+    return Parser<bool>(std::function<bool(std::string_view &)>(
+        [=](std::string_view &stream) -> bool
         {
-            if (stream.empty())
-            {
-                return std::nullopt;
-            }
-
-            size_t count = 0;
-            std::string result;
-            std::optional<std::string> temp;
-            for (size_t i = 0; i < times; ++i)
-            {
-                temp = parser(stream);
-                if (temp.has_value())
-                {
-                    result.append(temp.value());
-                    ++count;
-                }
-            }
-
-            if (count == times)
-            {
-                return result;
-            }
-            else
-            {
-                return std::nullopt;
-            }
+            return detail::recover(record, sync, nullptr, stream);
         }));
 }
@@ -0,0 +1,170 @@
+#pragma once
+
+
+// Opt-in instrumentation, compiled in only with PARSER_INSTRUMENT defined.
+// Costs are attributed to the innermost rule named with name_p(), everything outside
+// a named rule is reported as <unnamed>. Per rule it counts parser invocations, failed
+// invocations (the caller backtracks over them), bytes copied into owned string results
+// and heap allocations. Allocations are only seen in programs that include Allocations.hpp
+// in one translation unit or call profile_allocation() from their own operator new.
+// Counters are per thread.
+// Without PARSER_INSTRUMENT the hooks expand to nothing and name_p() returns its parser.
+
+#ifdef PARSER_INSTRUMENT
+
+#include <atomic>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct RuleStats
+{
+    size_t calls = 0;
+    size_t backtracks = 0;
+    size_t bytes_copied = 0;
+    size_t allocations = 0;
+};
+
+class Profile
+{
+private:
+    std::map<std::string, RuleStats> _rules;
+    // the stats of every name_p rule seen on this thread by its id, null until it runs
+    std::vector<RuleStats *> _by_id;
+    RuleStats _unnamed;
+    std::vector<RuleStats *> _stack;
+
+public:
+    // the innermost rule until the scope ends, also when the rule throws
+    class Scope
+    {
+    private:
+        Profile &_profile;
+
+    public:
+        Scope(Profile &profile, RuleStats &stats)
+            : _profile(profile)
+        {
+            _profile.enter(stats);
+        }
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+        ~Scope()
+        {
+            _profile.leave();
+        }
+    };
+
+    static Profile &current()
+    {
+        thread_local Profile profile;
+        return profile;
+    }
+
+    // a new id for a name_p rule, so its stats are looked up by name once per thread
+    static size_t next_id()
+    {
+        static std::atomic<size_t> ids(0);
+        return ids++;
+    }
+
+    RuleStats &rule(const std::string &name)
+    {
+        return _rules[name];
+    }
+
+    RuleStats &rule(const size_t id, const std::string &name)
+    {
+        if (id >= _by_id.size())
+        {
+            _by_id.resize(id + 1, nullptr);
+        }
+        if (_by_id[id] == nullptr)
+        {
+            _by_id[id] = &_rules[name];
+        }
+        return *_by_id[id];
+    }
+
+    RuleStats &top()
+    {
+        return _stack.empty() ? _unnamed : *_stack.back();
+    }
+
+    void enter(RuleStats &stats)
+    {
+        _stack.push_back(&stats);
+    }
+
+    void leave()
+    {
+        _stack.pop_back();
+    }
+
+    void reset()
+    {
+        for (std::pair<const std::string, RuleStats> &rule : _rules)
+        {
+            rule.second = RuleStats();
+        }
+        _unnamed = RuleStats();
+    }
+
+    void report(std::ostream &stream) const
+    {
+        const auto line = [&](const std::string &name, const RuleStats &stats)
+        {
+            stream << std::left << std::setw(16) << name << std::right << std::setw(12) << stats.calls
+                << std::setw(12) << stats.backtracks << std::setw(14) << stats.bytes_copied
+                << std::setw(14) << stats.allocations << '\n';
+        };
+        stream << std::left << std::setw(16) << "rule" << std::right << std::setw(12) << "calls"
+            << std::setw(12) << "backtracks" << std::setw(14) << "bytes copied" << std::setw(14) << "allocations" << '\n';
+        for (const std::pair<const std::string, RuleStats> &rule : _rules)
+        {
+            line(rule.first, rule.second);
+        }
+        line("<unnamed>", _unnamed);
+    }
+};
+
+inline void profile_call(const bool matched)
+{
+    RuleStats &stats = Profile::current().top();
+    ++stats.calls;
+    if (!matched)
+    {
+        ++stats.backtracks;
+    }
+}
+
+inline void profile_copy(const size_t bytes)
+{
+    Profile::current().top().bytes_copied += bytes;
+}
+
+inline void profile_allocation()
+{
+    thread_local bool busy = false;
+    if (!busy)
+    {
+        busy = true;
+        ++Profile::current().top().allocations;
+        busy = false;
+    }
+}
+
+#define PARSER_PROFILE_CALL(matched) profile_call(matched)
+#define PARSER_PROFILE_COPY(bytes) profile_copy(bytes)
+
+#else
+
+#define PARSER_PROFILE_CALL(matched) ((void)0)
+#define PARSER_PROFILE_COPY(bytes) ((void)0)
+
+#endif
@@ -0,0 +1,265 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PARSER_HAS_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARSER_HAS_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// Byte scanning kernels used by the combinators' fast paths.
+// Every function has a scalar fallback, SIMD is used where the target supports it.
+
+
+// 256-bit character class table.
+// The members are also kept as a short list of byte ranges, which is what the SIMD run
+// scanner tests; classes with more than max_ranges ranges are scanned with the table only.
+struct CharSet
+{
+    static constexpr size_t max_ranges = 6;
+
+    uint64_t bits[4] = {0, 0, 0, 0};
+    unsigned char lower[max_ranges] = {};
+    unsigned char width[max_ranges] = {};
+    size_t ranges = 0;
+
+    CharSet() {}
+
+    // "a-zA-Z_" style spec, a '-' at either end is taken literally
+    CharSet(const std::string_view spec)
+    {
+        for (size_t i = 0; i < spec.length(); ++i)
+        {
+            if (i + 2 < spec.length() && spec[i + 1] == '-')
+            {
+                set(spec[i], spec[i + 2]);
+                i += 2;
+            }
+            else
+            {
+                set(spec[i], spec[i]);
+            }
+        }
+    }
+
+    CharSet &set(const char first, const char last)
+    {
+        for (unsigned int ch = static_cast<unsigned char>(first); ch <= static_cast<unsigned char>(last); ++ch)
+        {
+            bits[ch >> 6] |= uint64_t(1) << (ch & 63);
+        }
+        update_ranges();
+        return *this;
+    }
+
+    inline bool test(const char ch) const
+    {
+        const unsigned char index = static_cast<unsigned char>(ch);
+        return (bits[index >> 6] >> (index & 63)) & 1;
+    }
+
+    // every byte that is not a member
+    CharSet operator~() const
+    {
+        CharSet result;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            result.bits[i] = ~bits[i];
+        }
+        result.update_ranges();
+        return result;
+    }
+
+    CharSet operator|(const CharSet &other) const
+    {
+        CharSet result;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            result.bits[i] = bits[i] | other.bits[i];
+        }
+        result.update_ranges();
+        return result;
+    }
+
+    void update_ranges()
+    {
+        ranges = 0;
+        for (unsigned int ch = 0; ch < 256;)
+        {
+            if (!test(static_cast<char>(ch)))
+            {
+                ++ch;
+                continue;
+            }
+            unsigned int last = ch;
+            while (last + 1 < 256 && test(static_cast<char>(last + 1)))
+            {
+                ++last;
+            }
+            if (ranges < max_ranges)
+            {
+                lower[ranges] = static_cast<unsigned char>(ch);
+                width[ranges] = static_cast<unsigned char>(last - ch);
+            }
+            ++ranges;
+            ch = last + 1;
+        }
+    }
+};
+
+namespace Scan
+{
+
+inline unsigned int lowest_bit(const unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// offset of the first a or b in stream at or after from, stream.length() if there is none
+inline size_t find_either(const std::string_view stream, size_t from, const char a, const char b)
+{
+    const char *data = stream.data();
+    const size_t length = stream.length();
+    if (a == b)
+    {
+        const void *found = from < length ? std::memchr(data + from, a, length - from) : nullptr;
+        return found == nullptr ? length : static_cast<const char *>(found) - data;
+    }
+#ifdef PARSER_HAS_SSE2
+    const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+    for (; from + 16 <= length; from += 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+        const unsigned int mask = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(block, va), _mm_cmpeq_epi8(block, vb)));
+        if (mask != 0)
+        {
+            return from + lowest_bit(mask);
+        }
+    }
+#endif
+    for (; from < length; ++from)
+    {
+        if (data[from] == a || data[from] == b)
+        {
+            return from;
+        }
+    }
+    return length;
+}
+
+// end of a balanced open ... close block for single-byte delimiters, counting from
+// depth already open blocks at from; stream.length() + 1 if the block is not closed
+inline size_t find_pair_end(const std::string_view stream, size_t from, const char open, const char close, size_t depth)
+{
+    const char *data = stream.data();
+    const size_t length = stream.length();
+#ifdef PARSER_HAS_SSE2
+    const __m128i vopen = _mm_set1_epi8(open), vclose = _mm_set1_epi8(close);
+    for (; from + 16 <= length; from += 16)
+    {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+        const unsigned int close_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, vclose));
+        unsigned int mask = close_mask | _mm_movemask_epi8(_mm_cmpeq_epi8(block, vopen));
+        while (mask != 0)
+        {
+            const unsigned int bit = lowest_bit(mask);
+            if (close_mask & (1u << bit))
+            {
+                if (--depth == 0)
+                {
+                    return from + bit + 1;
+                }
+            }
+            else
+            {
+                ++depth;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; from < length; ++from)
+    {
+        if (data[from] == close)
+        {
+            if (--depth == 0)
+            {
+                return from + 1;
+            }
+        }
+        else if (data[from] == open)
+        {
+            ++depth;
+        }
+    }
+    return length + 1;
+}
+
+// end of the run of class members starting at from
+inline size_t span_of(const CharSet &set, const std::string_view stream, size_t from = 0)
+{
+    const char *data = stream.data();
+    const size_t length = stream.length();
+    if (set.ranges <= CharSet::max_ranges)
+    {
+#ifdef PARSER_HAS_AVX2
+        for (; from + 32 <= length; from += 32)
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + from));
+            __m256i inside = _mm256_setzero_si256();
+            for (size_t i = 0; i < set.ranges; ++i)
+            {
+                const __m256i offset = _mm256_sub_epi8(block, _mm256_set1_epi8(set.lower[i]));
+                inside = _mm256_or_si256(inside, _mm256_cmpeq_epi8(
+                    _mm256_min_epu8(offset, _mm256_set1_epi8(set.width[i])), offset));
+            }
+            const unsigned int mask = ~static_cast<unsigned int>(_mm256_movemask_epi8(inside));
+            if (mask != 0)
+            {
+                return from + lowest_bit(mask);
+            }
+        }
+#endif
+#ifdef PARSER_HAS_SSE2
+        for (; from + 16 <= length; from += 16)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + from));
+            __m128i inside = _mm_setzero_si128();
+            for (size_t i = 0; i < set.ranges; ++i)
+            {
+                const __m128i offset = _mm_sub_epi8(block, _mm_set1_epi8(set.lower[i]));
+                inside = _mm_or_si128(inside, _mm_cmpeq_epi8(
+                    _mm_min_epu8(offset, _mm_set1_epi8(set.width[i])), offset));
+            }
+            const unsigned int mask = ~_mm_movemask_epi8(inside) & 0xFFFF;
+            if (mask != 0)
+            {
+                return from + lowest_bit(mask);
+            }
+        }
+#endif
+    }
+    while (from < length && set.test(data[from]))
+    {
+        ++from;
+    }
+    return from;
+}
+
+};
@@ -0,0 +1,498 @@
+#pragma once
+#include <type_traits>
+#include "BaseParser.hpp"
+
+
+// Statically typed parser family.
+// Every primitive and combinator is its own type (Seq<L, R>, Alt<L, R>, Many<P> ...),
+// so a whole grammar is one expression template the compiler can inline.
+// Type erasure only happens where it is asked for: to_parser() turns a static
+// grammar into a Parser<bool>, ref_p() calls back into a dynamic Parser<T>.
+// Functions live in namespace StaticParser and should be called qualified,
+// operators are found by ADL.
+
+namespace StaticParser
+{
+
+struct Tag {};
+
+template <typename P, typename F>
+struct Act;
+
+template <typename D>
+struct Base : Tag
+{
+    template <typename F>
+    constexpr Act<D, F> operator[](const F &func) const
+    {
+        return Act<D, F>(static_cast<const D &>(*this), func);
+    }
+};
+
+template <typename T>
+constexpr bool is_static_v = std::is_base_of<Tag, T>::value;
+
+template <typename T>
+using enable_static_t = std::enable_if_t<is_static_v<T>, int>;
+
+// primitives
+
+struct Ch : Base<Ch>
+{
+    using value_type = char;
+    char value;
+
+    constexpr Ch(const char ch)
+        : value(ch) {}
+
+    inline std::optional<char> parse(std::string_view &stream) const
+    {
+        if (!stream.empty() && stream.front() == value)
+        {
+            stream.remove_prefix(1);
+            return value;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        return parse(stream).has_value();
+    }
+};
+
+template <typename Pred>
+struct Class : Base<Class<Pred>>
+{
+    using value_type = char;
+    Pred pred;
+
+    constexpr Class(const Pred &p)
+        : pred(p) {}
+
+    inline std::optional<char> parse(std::string_view &stream) const
+    {
+        if (!stream.empty() && pred(stream.front()))
+        {
+            const char ch = stream.front();
+            stream.remove_prefix(1);
+            return ch;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        return parse(stream).has_value();
+    }
+};
+
+struct Str : Base<Str>
+{
+    using value_type = std::string_view;
+    std::string value;
+
+    Str(const std::string &str)
+        : value(str) {}
+
+    inline std::optional<std::string_view> parse(std::string_view &stream) const
+    {
+        if (stream.length() >= value.length() && stream.compare(0, value.length(), value) == 0)
+        {
+            const std::string_view result = stream.substr(0, value.length());
+            stream.remove_prefix(value.length());
+            return result;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        return parse(stream).has_value();
+    }
+};
+
+struct Eol : Base<Eol>
+{
+    using value_type = char;
+
+    inline std::optional<char> parse(std::string_view &stream) const
+    {
+        if (!stream.empty() && (stream.front() == 10 || stream.front() == 13))
+        {
+            const char ch = stream.front();
+            stream.remove_prefix(1);
+            if (ch == 13 && !stream.empty() && stream.front() == 10)
+            {
+                stream.remove_prefix(1);
+            }
+            return ch;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        return parse(stream).has_value();
+    }
+};
+
+struct Int : Base<Int>
+{
+    using value_type = int;
+
+    inline std::optional<int> parse(std::string_view &stream) const
+    {
+        return scan_int(stream);
+    }
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        return scan_int(stream).has_value();
+    }
+};
+
+struct Float : Base<Float>
+{
+    using value_type = double;
+
+    inline std::optional<double> parse(std::string_view &stream) const
+    {
+        return scan_float(stream);
+    }
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        return scan_float(stream).has_value();
+    }
+};
+
+// combinators
+
+template <typename L, typename R>
+struct Seq : Base<Seq<L, R>>
+{
+    using value_type = void;
+    L left;
+    R right;
+
+    constexpr Seq(const L &l, const R &r)
+        : left(l), right(r) {}
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        std::string_view stream_copy(stream);
+        if (left(stream_copy) && right(stream_copy))
+        {
+            stream = stream_copy;
+            return true;
+        }
+        else
+        {
+            return false;
+        }
+    }
+};
+
+template <typename L, typename R>
+struct Alt : Base<Alt<L, R>>
+{
+    using value_type = void;
+    L left;
+    R right;
+
+    constexpr Alt(const L &l, const R &r)
+        : left(l), right(r) {}
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        return left(stream) || right(stream);
+    }
+};
+
+template <typename P>
+struct Many : Base<Many<P>>
+{
+    using value_type = void;
+    P parser;
+
+    constexpr Many(const P &p)
+        : parser(p) {}
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        while (!stream.empty() && parser(stream));
+        return true;
+    }
+};
+
+template <typename P>
+struct Some : Base<Some<P>>
+{
+    using value_type = void;
+    P parser;
+
+    constexpr Some(const P &p)
+        : parser(p) {}
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        if (stream.empty() || !parser(stream))
+        {
+            return false;
+        }
+        while (!stream.empty() && parser(stream));
+        return true;
+    }
+};
+
+template <typename P>
+struct Opt : Base<Opt<P>>
+{
+    using value_type = void;
+    P parser;
+
+    constexpr Opt(const P &p)
+        : parser(p) {}
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        if (!stream.empty())
+        {
+            parser(stream);
+        }
+        return true;
+    }
+};
+
+// matched span of a sub-grammar, handed to actions as std::string_view
+template <typename P>
+struct Raw : Base<Raw<P>>
+{
+    using value_type = std::string_view;
+    P parser;
+
+    constexpr Raw(const P &p)
+        : parser(p) {}
+
+    inline std::optional<std::string_view> parse(std::string_view &stream) const
+    {
+        const std::string_view start(stream);
+        if (parser(stream))
+        {
+            return start.substr(0, start.length() - stream.length());
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        return parse(stream).has_value();
+    }
+};
+
+// semantic action, called with the parsed value when P has one
+template <typename P, typename F>
+struct Act : Base<Act<P, F>>
+{
+    using value_type = void;
+    P parser;
+    F func;
+
+    constexpr Act(const P &p, const F &f)
+        : parser(p), func(f) {}
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        if constexpr(std::is_void<typename P::value_type>::value)
+        {
+            if (parser(stream))
+            {
+                func();
+                return true;
+            }
+            return false;
+        }
+        else
+        {
+            std::optional<typename P::value_type> result = parser.parse(stream);
+            if (result.has_value())
+            {
+                func(result.value());
+                return true;
+            }
+            return false;
+        }
+    }
+};
+
+// boundary back into the std::function world, used for recursive rules
+template <typename T>
+struct Ref : Base<Ref<T>>
+{
+    using value_type = void;
+    const Parser<T> *parser;
+
+    constexpr Ref(const Parser<T> &p)
+        : parser(&p) {}
+
+    inline bool operator()(std::string_view &stream) const
+    {
+        if constexpr(std::is_same<T, bool>::value)
+        {
+            return (*parser)(stream);
+        }
+        else
+        {
+            return (*parser)(stream).has_value();
+        }
+    }
+};
+
+// operators
+
+template <typename L, typename R, enable_static_t<L> = 0, enable_static_t<R> = 0>
+constexpr Seq<L, R> operator>>(const L &left, const R &right)
+{
+    return Seq<L, R>(left, right);
+}
+
+template <typename L, enable_static_t<L> = 0>
+constexpr Seq<L, Ch> operator>>(const L &left, const char right)
+{
+    return Seq<L, Ch>(left, Ch(right));
+}
+
+template <typename L, typename R, enable_static_t<L> = 0, enable_static_t<R> = 0>
+constexpr Alt<L, R> operator|(const L &left, const R &right)
+{
+    return Alt<L, R>(left, right);
+}
+
+template <typename L, enable_static_t<L> = 0>
+constexpr Alt<L, Ch> operator|(const L &left, const char right)
+{
+    return Alt<L, Ch>(left, Ch(right));
+}
+
+template <typename P, enable_static_t<P> = 0>
+constexpr Many<P> operator*(const P &parser)
+{
+    return Many<P>(parser);
+}
+
+template <typename P, enable_static_t<P> = 0>
+constexpr Some<P> operator+(const P &parser)
+{
+    return Some<P>(parser);
+}
+
+template <typename P, enable_static_t<P> = 0>
+constexpr Opt<P> operator!(const P &parser)
+{
+    return Opt<P>(parser);
+}
+
+// functions
+
+constexpr Ch ch_p(const char value)
+{
+    return Ch(value);
+}
+
+inline Str str_p(const std::string &value)
+{
+    return Str(value);
+}
+
+constexpr auto range_p(const char lower, const char upper)
+{
+    return Class([=](const char ch) { return lower <= ch && ch <= upper; });
+}
+
+constexpr auto anychar_p()
+{
+    return Class([](const char) { return true; });
+}
+
+constexpr auto alpha_p()
+{
+    return Class([](const char ch) { return ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z'); });
+}
+
+constexpr auto alphaa_p()
+{
+    return Class([](const char ch) { return 'A' <= ch && ch <= 'Z'; });
+}
+
+constexpr auto alphab_p()
+{
+    return Class([](const char ch) { return 'a' <= ch && ch <= 'z'; });
+}
+
+constexpr auto digit_p()
+{
+    return Class([](const char ch) { return '0' <= ch && ch <= '9'; });
+}
+
+constexpr auto alnum_p()
+{
+    return Class([](const char ch)
+        { return ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z') || ('0' <= ch && ch <= '9'); });
+}
+
+constexpr Eol eol_p()
+{
+    return Eol();
+}
+
+constexpr Int int_p()
+{
+    return Int();
+}
+
+constexpr Float float_p()
+{
+    return Float();
+}
+
+template <typename P, enable_static_t<P> = 0>
+constexpr Raw<P> raw_p(const P &parser)
+{
+    return Raw<P>(parser);
+}
+
+template <typename P, typename F, enable_static_t<P> = 0>
+constexpr Act<P, F> act_p(const P &parser, const F &func)
+{
+    return Act<P, F>(parser, func);
+}
+
+template <typename T>
+constexpr Ref<T> ref_p(const Parser<T> &parser)
+{
+    return Ref<T>(parser);
+}
+
+template <typename P, enable_static_t<P> = 0>
+inline Parser<bool> to_parser(const P &parser)
+{
+    return Parser<bool>(std::function<bool(std::string_view &)>(parser));
+}
+
+};
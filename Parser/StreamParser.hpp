@@ -0,0 +1,184 @@
+#pragma once
+#include <istream>
+#include "BaseParser.hpp"
+#include "Memo.hpp"
+
+
+// Incremental driver for the top-level repetition of a record grammar,
+// i.e. *record over input that arrives in chunks from a pipe or socket.
+// Records are taken from the front of an internal buffer one by one; a record
+// that fails or runs into the end of the buffer is retried once more input has been fed,
+// so a chunk boundary never breaks a record. Consumed input is dropped, the buffer
+// only ever holds the unfinished record plus the newest chunk and is capped by max_buffer.
+// Records are expected to be self-delimiting (end in eol_p(), ';' ...). Given their delimiter,
+// the parser only hands complete records to the grammar, up to the last delimiter seen, so
+// every record is parsed once. Without a delimiter a record is only accepted once it stops
+// before the end of the buffer, and a record that runs into the end is parsed again from its
+// first byte on the next feed(). Its actions would fire on every retry, so this mode only
+// takes a Parser<T> record with a sink and no actions in its grammar: the sink sees each
+// record once, when it is accepted.
+// A record that fails after passing a cut_p is not retried when it failed before the end of
+// the buffer: more input cannot change the outcome, so the error is reported right away
+// instead of after max_buffer bytes.
+// Every feed() parses in a new Memo::Session, so memoized rules never answer from the
+// contents the buffer held before it was compacted or appended to.
+
+enum class StreamStatus {NEED_MORE, DONE, FAILED};
+
+template <typename T>
+class StreamParser
+{
+private:
+    Parser<T> _record;
+    std::function<void(T &&)> _sink;
+    std::optional<char> _delimiter;
+    std::string _buffer;
+    size_t _offset = 0;
+    size_t _consumed = 0;
+    size_t _count = 0;
+    size_t _max_buffer;
+    StreamStatus _status = StreamStatus::NEED_MORE;
+
+    // parses records from the buffer, at_end means no more input will follow
+    StreamStatus run(const bool at_end)
+    {
+        // feed() has moved or rewritten the buffer, results memoized before are stale
+        const Memo::Session session(_buffer);
+        size_t limit = _buffer.length();
+        if (!at_end && _delimiter.has_value())
+        {
+            const size_t last = _buffer.find_last_of(_delimiter.value());
+            limit = last == std::string::npos || last < _offset ? _offset : last + 1;
+        }
+        const bool complete = at_end || _delimiter.has_value();
+
+        while (_offset < limit)
+        {
+            const std::string_view stream(_buffer.data() + _offset, limit - _offset);
+            std::string_view stream_copy(stream);
+            const size_t passed = Cut::current().passed;
+            // where the record failed, to tell a failure past a cut short of the end of the buffer
+            Failure failure;
+            const Context<Failure>::Scope failure_scope(failure);
+            std::optional<T> result;
+            if constexpr(std::is_same<T, bool>::value)
+            {
+                if (_record(stream_copy))
+                {
+                    result = true;
+                }
+            }
+            else
+            {
+                result = _record(stream_copy);
+            }
+
+            const size_t length = stream.length() - stream_copy.length();
+            if (result.has_value() && length > 0 && (complete || !stream_copy.empty()))
+            {
+                _offset += length;
+                _consumed += length;
+                ++_count;
+                if constexpr(!std::is_same<T, bool>::value)
+                {
+                    if (_sink)
+                    {
+                        _sink(std::move(result.value()));
+                    }
+                }
+            }
+            else if (!complete && stream.length() < _max_buffer
+                && (Cut::current().passed == passed
+                || !(failure.failed() && failure.position < stream.data() + stream.length())))
+            {
+                return StreamStatus::NEED_MORE;
+            }
+            else
+            {
+                return StreamStatus::FAILED;
+            }
+        }
+        if (at_end)
+        {
+            return StreamStatus::DONE;
+        }
+        return _buffer.length() - _offset < _max_buffer ? StreamStatus::NEED_MORE : StreamStatus::FAILED;
+    }
+
+public:
+    // only hands complete records to the grammar: input is parsed up to the last delimiter seen,
+    // so actions never fire for a record that is still being received
+    StreamParser(const char delimiter, const Parser<T> &record, const size_t max_buffer = 1 << 20)
+        : _record(record), _delimiter(delimiter), _max_buffer(max_buffer) {}
+
+    StreamParser(const char delimiter, const Parser<T> &record, const std::function<void(T &&)> &sink,
+        const size_t max_buffer = 1 << 20)
+        : _record(record), _sink(sink), _delimiter(delimiter), _max_buffer(max_buffer) {}
+
+    // without a delimiter, for records whose grammar has no actions, see above
+    StreamParser(const Parser<T> &record, const std::function<void(T &&)> &sink, const size_t max_buffer = 1 << 20)
+        : _record(record), _sink(sink), _max_buffer(max_buffer)
+    {
+        static_assert(!std::is_same<T, bool>::value,
+            "a StreamParser without a delimiter retries records, their results must go to a sink");
+    }
+
+    // appends a chunk and parses every record that is complete so far
+    StreamStatus feed(const std::string_view chunk)
+    {
+        if (_status != StreamStatus::NEED_MORE)
+        {
+            return _status;
+        }
+        _buffer.erase(0, _offset);
+        _offset = 0;
+        _buffer.append(chunk);
+        return _status = run(false);
+    }
+
+    // end of input, the remaining bytes must form complete records
+    StreamStatus finish()
+    {
+        if (_status == StreamStatus::NEED_MORE)
+        {
+            _status = run(true);
+        }
+        return _status;
+    }
+
+    StreamStatus pump(std::istream &input, const size_t chunk_size = 1 << 16)
+    {
+        std::string chunk(chunk_size, '\0');
+        while (_status == StreamStatus::NEED_MORE && input)
+        {
+            input.read(chunk.data(), chunk_size);
+            if (input.gcount() > 0)
+            {
+                feed(std::string_view(chunk.data(), input.gcount()));
+            }
+        }
+        return finish();
+    }
+
+    StreamStatus status() const
+    {
+        return _status;
+    }
+
+    // number of records parsed so far
+    size_t count() const
+    {
+        return _count;
+    }
+
+    // stream offset of the first byte that has not been consumed
+    size_t consumed() const
+    {
+        return _consumed;
+    }
+
+    std::string_view pending() const
+    {
+        return std::string_view(_buffer.data() + _offset, _buffer.length() - _offset);
+    }
+};
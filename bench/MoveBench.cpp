@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include "../Parser/Allocations.hpp"
+#include "../Parser/ParserGen1.hpp"
+
+
+// Copies in the value-building ParserGen1 combinators on string-heavy grammars.
+// usage: move_bench [size_in_bytes]
+// Reports throughput and heap allocations per record, every copy of a std::string,
+// std::vector or a tuple holding them shows up as an extra allocation.
+
+template <typename T>
+static void run(const std::string &name, const Parser<T> &record, const std::string &input, const size_t records)
+{
+    size_t rounds = 0, checksum = 0;
+    allocations = 0;
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> time(0);
+    while (time.count() < 0.5 || rounds == 0)
+    {
+        std::string_view stream(input);
+        while (!stream.empty())
+        {
+            const std::optional<T> result = record(stream);
+            if (!result.has_value())
+            {
+                std::cerr << name << " failed" << std::endl;
+                std::exit(1);
+            }
+            checksum += sizeof(result.value());
+        }
+        ++rounds;
+        time = std::chrono::steady_clock::now() - start;
+    }
+    std::cout << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(12) << input.size() * rounds / time.count() / (1 << 20)
+        << std::setw(16) << static_cast<double>(allocations) / (records * rounds) << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t size = argc > 1 ? std::stoull(argv[1]) : (1 << 20);
+
+    // "name=value;" records of 5-20 letter words
+    std::mt19937 random(20240101);
+    std::string input;
+    size_t records = 0;
+    while (input.size() < size)
+    {
+        for (const char end : {'=', ';'})
+        {
+            for (size_t i = 0, length = 5 + random() % 16; i < length; ++i)
+            {
+                input.push_back(static_cast<char>('a' + random() % 26));
+            }
+            input.push_back(end);
+        }
+        ++records;
+    }
+
+    const Parser<std::string> word = +alpha_p();
+    std::cout << std::left << std::setw(14) << "grammar" << std::right << std::setw(12) << "MB/s"
+        << std::setw(16) << "allocs/record" << std::endl;
+    run("concat", word >> ch_p('=') >> word >> ch_p(';'), input, records);
+    run("tuple", (word >> ch_p('=')) >> ((word >> ch_p(';')) | int_p()), input, records);
+    run("vector", *(word >> (ch_p('=') | ch_p(';'))), input, records * 2);
+    run("repeat_p", repeat_p(2, word >> (ch_p('=') | ch_p(';'))), input, records);
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include "../Parser/BaseParser.hpp"
+
+
+// Microbenchmark of int_p()/float_p() against the previous
+// std::vector<char> + std::stoi/std::stod implementation.
+
+namespace Legacy
+{
+
+std::optional<int> int_func(std::string_view &stream)
+{
+    if (stream.empty())
+    {
+        return std::nullopt;
+    }
+    size_t index = 0;
+    std::vector<char> num;
+    if (stream.front() == '+')
+    {
+        ++index;
+    }
+    else if (stream.front() == '-')
+    {
+        ++index;
+        num.emplace_back('-');
+    }
+    while (index < stream.length() && '0' <= stream[index] && stream[index] <= '9')
+    {
+        num.emplace_back(stream[index++]);
+    }
+    if (num.empty())
+    {
+        return std::nullopt;
+    }
+    else
+    {
+        stream.remove_prefix(index);
+        return std::stoi(std::string(num.cbegin(), num.cend()));
+    }
+}
+
+std::optional<double> float_func(std::string_view &stream)
+{
+    if (stream.empty())
+    {
+        return std::nullopt;
+    }
+    size_t index = 0;
+    std::vector<char> num;
+    if (stream.front() == '+')
+    {
+        ++index;
+    }
+    else if (stream.front() == '-')
+    {
+        ++index;
+        num.emplace_back('-');
+    }
+    bool find_point = false;
+    while (index < stream.length() && (('0' <= stream[index] && stream[index] <= '9')
+        || (stream[index] == '.' && !find_point)) )
+    {
+        num.emplace_back(stream[index]);
+        if (stream[index++] == '.')
+        {
+            find_point = true;
+        }
+    }
+    if (index < stream.length() && !num.empty() && (stream[index] == 'e' || stream[index] == 'E'))
+    {
+        num.emplace_back(stream[index++]);
+        if (index < stream.length() && stream[index] == '-')
+        {
+            num.emplace_back(stream[index++]);
+        }
+        while (index < stream.length() && ('0' <= stream[index] && stream[index] <= '9'))
+        {
+            num.emplace_back(stream[index++]);
+        }
+        while (!num.empty() && (num.back() < '0' || num.back() > '9'))
+        {
+            num.pop_back();
+            --index;
+        }
+    }
+    if (num.empty())
+    {
+        return std::nullopt;
+    }
+    else
+    {
+        stream.remove_prefix(index);
+        return std::stod(std::string(num.cbegin(), num.cend()));
+    }
+}
+
+};
+
+template <typename T>
+double run(const Parser<T> &parser, const std::string &input, double &checksum)
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::string_view stream(input);
+    while (!stream.empty())
+    {
+        std::optional<T> value = parser(stream);
+        if (value.has_value())
+        {
+            checksum += value.value();
+        }
+        stream.remove_prefix(stream.empty() ? 0 : 1);
+    }
+    const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    return input.size() / time.count() / (1 << 20);
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> ints(-100000, 100000);
+    std::string int_input, float_input;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const int value = ints(random);
+        int_input.append(std::to_string(value)).push_back(',');
+        // value / 1000 with three fraction digits, "-0.042" included
+        const std::string fraction = std::to_string(std::abs(value) % 1000);
+        float_input.append(value < 0 ? "-" : "").append(std::to_string(std::abs(value) / 1000)).push_back('.');
+        float_input.append(3 - fraction.length(), '0').append(fraction).push_back(',');
+    }
+
+    double legacy_sum = 0, new_sum = 0;
+    std::cout << "int_p   legacy " << run(Parser<int>(Legacy::int_func), int_input, legacy_sum) << " MB/s, "
+        << "from_chars " << run(int_p(), int_input, new_sum) << " MB/s" << std::endl;
+    std::cout << "float_p legacy " << run(Parser<double>(Legacy::float_func), float_input, legacy_sum) << " MB/s, "
+        << "from_chars " << run(float_p(), float_input, new_sum) << " MB/s" << std::endl;
+    if (legacy_sum != new_sum)
+    {
+        std::cout << "checksum mismatch: " << legacy_sum << " != " << new_sum << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include "../Parser/ParserGen2.hpp"
+#include "../Parser/ParallelParser.hpp"
+
+
+// Scaling of parallel_parse over ';' delimited "name=value;" records.
+// usage: parallel_bench [size_in_bytes] [max_threads]
+// Each thread count is checked against a sequential run of the same grammar.
+
+struct Total
+{
+    long long sum = 0;
+
+    void add(const int value)
+    {
+        sum += value;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    const size_t size = argc > 1 ? std::stoull(argv[1]) : (64 << 20);
+    const size_t max_threads = argc > 2 ? std::stoull(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    std::mt19937 random(20240101);
+    std::string input;
+    input.reserve(size + 32);
+    while (input.size() < size)
+    {
+        for (size_t i = 0, length = 2 + random() % 10; i < length; ++i)
+        {
+            input.push_back(static_cast<char>('a' + random() % 26));
+        }
+        input.append("=").append(std::to_string(random() % 100000)).push_back(';');
+    }
+
+    Action<int> add(&Total::add);
+    Parser<int> value = int_p();
+    value[add];
+    const Parser<bool> record = +alpha_p() >> ch_p('=') >> value >> ch_p(';');
+
+    Total expected;
+    {
+        const Context<Total>::Scope scope(expected);
+        std::string_view stream(input);
+        while (!stream.empty() && record(stream)) {}
+    }
+
+    std::cout << std::left << std::setw(10) << "threads" << std::right << std::setw(12) << "MB/s"
+        << std::setw(12) << "speedup" << std::endl;
+    double base = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const ParallelResult<bool, Total> result = parallel_parse<Total>(record, input, ';', threads);
+        const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+
+        long long sum = 0;
+        for (const Total &total : result.sinks)
+        {
+            sum += total.sum;
+        }
+        if (sum != expected.sum || result.error.has_value())
+        {
+            std::cerr << "mismatch with " << threads << " threads" << std::endl;
+            return 1;
+        }
+        const double speed = input.size() / time.count() / (1 << 20);
+        base = threads == 1 ? speed : base;
+        std::cout << std::left << std::setw(10) << threads << std::right << std::fixed << std::setprecision(2)
+            << std::setw(12) << speed << std::setw(12) << speed / base << std::endl;
+    }
+    return 0;
+}
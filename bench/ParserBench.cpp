@@ -0,0 +1,386 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <streambuf>
+#include <string>
+#include "../ExpParser.hpp"
+#include "../Parser/Allocations.hpp"
+#include "../Parser/Bytecode.hpp"
+
+
+// Grammar-level benchmarks.
+// usage: parser_bench [max_size_in_bytes] [name_filter]
+// Every benchmark runs a record parser repeatedly over generated input of 1 KB, 32 KB,
+// 1 MB, 32 MB and 1 GB (up to max_size, 1 MB by default) and reports throughput,
+// heap allocations per input byte and nanoseconds per parser call.
+// Inputs come from a fixed seed, so runs are reproducible.
+
+struct NullBuffer : std::streambuf
+{
+    int overflow(int ch) override
+    {
+        return ch;
+    }
+};
+
+struct Bench
+{
+    std::string name;
+    std::function<std::string(size_t)> generate;
+    std::function<bool(std::string_view &)> parse;
+};
+
+// repeats text generated by record until the input has size bytes
+static std::string generate(const size_t size, const std::function<void(std::mt19937 &, std::string &)> &record)
+{
+    std::mt19937 random(20240101);
+    std::string input;
+    input.reserve(size + 64);
+    while (input.size() < size)
+    {
+        record(random, input);
+    }
+    input.resize(size);
+    return input;
+}
+
+static std::string number(std::mt19937 &random)
+{
+    return std::to_string(static_cast<int>(random() % 200001) - 100000);
+}
+
+static std::string decimal(std::mt19937 &random)
+{
+    return number(random) + '.' + std::to_string(random() % 1000);
+}
+
+static std::string word(std::mt19937 &random)
+{
+    std::string result;
+    const size_t length = 2 + random() % 10;
+    for (size_t i = 0; i < length; ++i)
+    {
+        result.push_back("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"[random() % 52]);
+    }
+    return result;
+}
+
+static std::string expression(std::mt19937 &random, const size_t depth)
+{
+    std::string result = number(random).substr(1);
+    const size_t terms = 1 + random() % 4;
+    for (size_t i = 0; i < terms; ++i)
+    {
+        result.append(" ").push_back("+-*/"[random() % 4]);
+        if (depth > 0 && random() % 3 == 0)
+        {
+            result.append(" (").append(expression(random, depth - 1)).append(")");
+        }
+        else
+        {
+            result.append(" ").append(std::to_string(1 + random() % 999));
+        }
+    }
+    return result;
+}
+
+// operators of 8 precedence levels, loosest first, "1<2+3*(4|5)"
+static const char precedence_operators[] = "|^&=<+*%";
+
+static std::string nested(std::mt19937 &random, const size_t depth)
+{
+    std::string result = std::to_string(random() % 1000);
+    const size_t terms = random() % 6;
+    for (size_t i = 0; i < terms; ++i)
+    {
+        result.push_back(precedence_operators[random() % 8]);
+        if (depth > 0 && random() % 4 == 0)
+        {
+            result.append("(").append(nested(random, depth - 1)).append(")");
+        }
+        else
+        {
+            result.append(std::to_string(random() % 1000));
+        }
+    }
+    return result;
+}
+
+// one rule per precedence level, level i is level i + 1 (operator level i + 1)*
+static Parser<bool> precedence_levels[9];
+
+static Parser<bool> precedence_rules()
+{
+    precedence_levels[8] = int_p() | (ch_p('(') >> std::ref(precedence_levels[0]) >> ch_p(')'));
+    for (size_t i = 8; i-- > 0;)
+    {
+        precedence_levels[i] = std::ref(precedence_levels[i + 1])
+            >> *(ch_p(precedence_operators[i]) >> std::ref(precedence_levels[i + 1]));
+    }
+    return precedence_levels[0];
+}
+
+static Parser<bool> precedence_expression;
+
+static Parser<bool> precedence_table()
+{
+    std::vector<InfixOperator<bool>> operators;
+    for (int i = 0; i < 8; ++i)
+    {
+        operators.push_back({ch_p(precedence_operators[i]), i, Associativity::LEFT, Action<void>()});
+    }
+    precedence_expression = expression_p(int_p() | (ch_p('(') >> std::ref(precedence_expression) >> ch_p(')')),
+        operators);
+    return precedence_expression;
+}
+
+// the same 8 levels as a Bytecode grammar
+static Parser<bool> precedence_program()
+{
+    namespace bc = Bytecode;
+    bc::Grammar grammar;
+    grammar.define("8", bc::int_p() | (bc::ch_p('(') >> bc::rule_p("0") >> ')'));
+    for (size_t i = 0; i < 8; ++i)
+    {
+        grammar.define(std::to_string(i), bc::rule_p(std::to_string(i + 1))
+            >> *(bc::ch_p(precedence_operators[i]) >> bc::rule_p(std::to_string(i + 1))));
+    }
+    grammar.define("record", bc::rule_p("0") >> ';');
+    return Bytecode::to_parser(grammar.compile("record").value());
+}
+
+// one parser call per record, a failed call skips a byte so every benchmark terminates
+template <typename T>
+static std::function<bool(std::string_view &)> records(const Parser<T> &parser)
+{
+    return [=](std::string_view &stream)
+    {
+        if constexpr(std::is_same<T, bool>::value)
+        {
+            return parser(stream);
+        }
+        else
+        {
+            return parser(stream).has_value();
+        }
+    };
+}
+
+// 40 commands keyed by a leading letter, "ax12;" ... "ty-5;"
+static Parser<bool> commands()
+{
+    Parser<bool> result = ch_p('a') >> ch_p('x') >> int_p() >> ch_p(';');
+    for (size_t i = 1; i < 40; ++i)
+    {
+        result = result | (ch_p(static_cast<char>('a' + i / 2)) >> ch_p(i % 2 ? 'y' : 'x') >> int_p() >> ch_p(';'));
+    }
+    return result;
+}
+
+struct Total
+{
+    long long sum = 0;
+
+    void add(const int value)
+    {
+        sum += value;
+    }
+};
+
+static Total total;
+
+struct Plotter
+{
+    std::vector<int> coordinates;
+};
+
+// "PA" followed by 8 comma-separated coordinates, "PA120,-7,3301,...;"
+static void coordinates(std::mt19937 &random, std::string &s)
+{
+    s.append("PA");
+    for (size_t i = 0; i < 8; ++i)
+    {
+        s.append(i == 0 ? "" : ",").append(number(random));
+    }
+    s.push_back(';');
+}
+static Action<int> bound_action(&total, &Total::add);
+
+static const char *const plotter_commands[] = {"IN", "SP", "PU", "PD", "PA", "PR", "LB", "CI",
+    "SC", "IP", "SI", "DI", "LT", "VS", "EA", "ER"};
+
+static Parser<std::string> plotter_alternation()
+{
+    Parser<std::string> result = str_p(plotter_commands[0]);
+    for (size_t i = 1; i < 16; ++i)
+    {
+        result = result | str_p(plotter_commands[i]);
+    }
+    return result;
+}
+
+static std::vector<Bench> benches()
+{
+    const Parser<char> comma = ch_p(','), semicolon = ch_p(';');
+    std::vector<Bench> result;
+    const auto add = [&](const std::string &name, const std::function<void(std::mt19937 &, std::string &)> &record,
+        const std::function<bool(std::string_view &)> &parse)
+    {
+        result.push_back({name, [=](const size_t size) { return generate(size, record); }, parse});
+    };
+
+    add("int_p", [](std::mt19937 &r, std::string &s) { s.append(number(r)).push_back(','); },
+        records(int_p() >> comma));
+    add("float_p", [](std::mt19937 &r, std::string &s) { s.append(decimal(r)).push_back(','); },
+        records(float_p() >> comma));
+    add("str_p", [](std::mt19937 &r, std::string &s) { s.append(r() % 2 ? "PU" : "PD"); },
+        records(str_p("PU") | str_p("PD")));
+    add("[] bind", [](std::mt19937 &r, std::string &s) { s.append(number(r)).push_back(','); },
+        records(int_p()[bound_action] >> comma));
+    add("[] action<>", [](std::mt19937 &r, std::string &s) { s.append(number(r)).push_back(','); },
+        records(int_p()[action<&Total::add>(&total)] >> comma));
+    add("str_p x16", [](std::mt19937 &r, std::string &s) { s.append(plotter_commands[r() % 16]); },
+        records(plotter_alternation()));
+    add("keywords_p", [](std::mt19937 &r, std::string &s) { s.append(plotter_commands[r() % 16]); },
+        records(keywords_p(std::vector<std::string>(plotter_commands, plotter_commands + 16))));
+    add("bytecode >>", [](std::mt19937 &r, std::string &s)
+        {
+            s.append(word(r)).append("=").append(number(r)).push_back(';');
+        },
+        records(Bytecode::to_parser([]()
+        {
+            Bytecode::Grammar grammar;
+            grammar.define("record", +Bytecode::alpha_p() >> '=' >> Bytecode::int_p() >> ';');
+            return grammar.compile("record").value();
+        }())));
+    add("eol_p", [](std::mt19937 &r, std::string &s) { s.append(r() % 2 ? "\r\n" : "\n"); },
+        records(eol_p()));
+    add(">>", [](std::mt19937 &r, std::string &s) { s.append(word(r)).append("=").append(number(r)).push_back(';'); },
+        records(+alpha_p() >> ch_p('=') >> int_p() >> semicolon));
+    add("|", [](std::mt19937 &r, std::string &s) { s.push_back("+-*/"[r() % 4]); },
+        records(ch_p('+') | ch_p('-') | ch_p('*') | ch_p('/')));
+    add("| x40", [](std::mt19937 &r, std::string &s)
+        {
+            s.push_back(static_cast<char>('a' + r() % 20));
+            s.append(r() % 2 ? "x" : "y").append(number(r)).push_back(';');
+        },
+        records(commands()));
+    add("*", [](std::mt19937 &r, std::string &s) { s.append(word(r)).push_back(' '); },
+        records(*alnum_p() >> ch_p(' ')));
+    add("+", [](std::mt19937 &r, std::string &s) { s.append(word(r)).push_back(' '); },
+        records(+alnum_p() >> ch_p(' ')));
+    add("~", [](std::mt19937 &r, std::string &s) { s.append(word(r)).push_back(';'); },
+        records(~semicolon));
+    add("-", [](std::mt19937 &r, std::string &s) { s.append(word(r)).push_back(';'); },
+        records((+alpha_p() - semicolon) >> semicolon));
+    add("pair_p", [](std::mt19937 &r, std::string &s) { s.append("(").append(expression(r, 3)).append(")"); },
+        records(pair_p(ch_p('('), ch_p(')'))));
+    add("confix_p", [](std::mt19937 &r, std::string &s) { s.append("<").append(word(r)).append(">"); },
+        records(confix_p(ch_p('<'), ch_p('>'))));
+    add("repeat_p", [](std::mt19937 &r, std::string &s) { s.append(std::to_string(1000 + r() % 9000)); },
+        records(repeat_p(4, digit_p())));
+    add("repeat_p 2,8", [](std::mt19937 &r, std::string &s) { s.append(word(r).substr(0, 8)).push_back(' '); },
+        records(repeat_p(2, 8, alpha_p() | ch_p('_')) >> ch_p(' ')));
+    add("recover_p", [](std::mt19937 &r, std::string &s)
+        {
+            // one record in a hundred lacks its number
+            s.append(word(r)).append("=").append(r() % 100 ? number(r) : "").push_back('\n');
+        },
+        [parser = recover_p(+alpha_p() >> ch_p('=') >> int_p() >> eol_p(), eol_p())](std::string_view &stream)
+        {
+            static thread_local Recovery recovery;
+            recovery.skipped.clear();
+            const Context<Recovery>::Scope scope(recovery);
+            return parser(stream);
+        });
+    add("list_p", coordinates, records(str_p("PA") >> list_p(int_p(), comma) >> semicolon));
+    add("sep_by_p", coordinates, records(str_p("PA") >> sep_by_p(int_p(), comma) >> semicolon));
+    add("sep_by_p []", coordinates,
+        [parser = str_p("PA") >> sep_by_p(int_p(), comma, &Plotter::coordinates, 8) >> semicolon](std::string_view &stream)
+        {
+            static thread_local Plotter plotter;
+            plotter.coordinates.clear();
+            const Context<Plotter>::Scope scope(plotter);
+            return parser(stream);
+        });
+    // the values of many records collected in one vector
+    add("sep_by_p [] all", coordinates,
+        [parser = str_p("PA") >> sep_by_p(int_p(), comma, &Plotter::coordinates, 8) >> semicolon](std::string_view &stream)
+        {
+            static thread_local Plotter plotter;
+            if (plotter.coordinates.size() >= (1 << 20))
+            {
+                plotter.coordinates.clear();
+            }
+            const Context<Plotter>::Scope scope(plotter);
+            return parser(stream);
+        });
+    add("rules x8", [](std::mt19937 &r, std::string &s) { s.append(nested(r, 3)).push_back(';'); },
+        records(precedence_rules() >> semicolon));
+    add("expression_p", [](std::mt19937 &r, std::string &s) { s.append(nested(r, 3)).push_back(';'); },
+        records(precedence_table() >> semicolon));
+    add("bytecode x8", [](std::mt19937 &r, std::string &s) { s.append(nested(r, 3)).push_back(';'); },
+        records(precedence_program()));
+    add("ExpParser", [](std::mt19937 &r, std::string &s) { s.append(expression(r, 4)).push_back(';'); },
+        [](std::string_view &stream)
+        {
+            const bool matched = ExpParser::parse(stream);
+            if (!stream.empty() && stream.front() == ';')
+            {
+                stream.remove_prefix(1);
+            }
+            return matched;
+        });
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t max_size = argc > 1 ? std::stoull(argv[1]) : (1 << 20);
+    const std::string filter = argc > 2 ? argv[2] : "";
+
+    NullBuffer null_buffer;
+    std::streambuf *const stdout_buffer = std::cout.rdbuf();
+
+    std::cout << std::left << std::setw(12) << "benchmark" << std::right << std::setw(12) << "size"
+        << std::setw(12) << "MB/s" << std::setw(14) << "allocs/byte" << std::setw(12) << "ns/op" << std::endl;
+    for (const Bench &bench : benches())
+    {
+        if (!filter.empty() && bench.name != filter)
+        {
+            continue;
+        }
+        for (size_t size = 1 << 10; size <= max_size; size <<= 5)
+        {
+            const std::string input = bench.generate(size);
+            size_t rounds = 0, ops = 0, bytes = 0;
+            allocations = 0;
+            std::cout.rdbuf(&null_buffer);
+            const auto start = std::chrono::steady_clock::now();
+            std::chrono::duration<double> time(0);
+            while (time.count() < 0.2 || rounds == 0)
+            {
+                std::string_view stream(input);
+                while (!stream.empty())
+                {
+                    if (!bench.parse(stream))
+                    {
+                        stream.remove_prefix(1);
+                    }
+                    ++ops;
+                }
+                bytes += input.size();
+                ++rounds;
+                time = std::chrono::steady_clock::now() - start;
+            }
+            std::cout.rdbuf(stdout_buffer);
+
+            std::cout << std::left << std::setw(12) << bench.name << std::right << std::setw(12) << size
+                << std::fixed << std::setprecision(2) << std::setw(12) << bytes / time.count() / (1 << 20)
+                << std::setprecision(4) << std::setw(14) << static_cast<double>(allocations) / bytes
+                << std::setprecision(1) << std::setw(12) << time.count() * 1e9 / ops << std::endl;
+        }
+    }
+    return 0;
+}
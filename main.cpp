@@ -1,6 +1,9 @@
 #include <iostream>
 #include "ExpParser.hpp"
-
+#include "Parser/StaticParser.hpp"
+#ifdef PARSER_INSTRUMENT
+#include "Parser/Allocations.hpp"
+#endif
 
 int main()
 {
@@ -20,5 +23,20 @@ int main()
         std::cout << result.value() << std::endl;
     }
 
+    namespace sp = StaticParser;
+    int sum = 0;
+    auto add = [&](const int value) { sum += value; };
+    auto num = sp::int_p()[add];
+    auto list = num >> *(*sp::ch_p(' ') >> sp::ch_p(',') >> *sp::ch_p(' ') >> num);
+    std::string_view exp3("1, 2, 3, 4");
+    if (list(exp3))
+    {
+        std::cout << sum << std::endl;
+    }
+
+#ifdef PARSER_INSTRUMENT
+    Profile::current().report(std::cout);
+#endif
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include <string>
+#include <vector>
+#include "../Parser/ParserGen2.hpp"
+#include "../Parser/Ast.hpp"
+#include "Check.hpp"
+
+
+// ast_p trees, nodes dropped after backtracking, and the Arena under them.
+
+using Nodes = std::vector<std::pair<int, std::string_view>>;
+
+// kind and text of the children of parent
+static Nodes children(const AstNode &parent)
+{
+    Nodes result;
+    for (const AstNode *node = parent.first_child; node != nullptr; node = node->next_sibling)
+    {
+        result.emplace_back(node->kind, node->text);
+    }
+    return result;
+}
+
+int main()
+{
+    // without a builder ast_p only matches
+    {
+        const Parser<AstNode *> number = ast_p(1, int_p());
+        std::string_view stream("42;");
+        const std::optional<AstNode *> node = number(stream);
+        CHECK(node.has_value() && node.value() == nullptr);
+        CHECK(stream == ";");
+    }
+
+    AstBuilder builder;
+    const Context<AstBuilder>::Scope scope(builder);
+
+    // a node per match, with the value of the rule
+    {
+        const Parser<bool> list = ast_p(1, int_p()) >> *(ch_p(',') >> ast_p(1, int_p()));
+        std::string_view stream("10,-2,3");
+        CHECK(list(stream));
+        CHECK(children(builder.root()) == Nodes({{1, "10"}, {1, "-2"}, {1, "3"}}));
+        CHECK(builder.root().first_child->value<int>() == 10);
+        CHECK(builder.root().last_child->value<int>() == 3);
+        CHECK(builder.root().last_child->previous_sibling->value<int>() == -2);
+        builder.reset();
+        CHECK(builder.root().first_child == nullptr);
+    }
+
+    // nested rules become children
+    {
+        const Parser<bool> group = ast_p(2, ch_p('[') >> ast_p(1, int_p()) >> *(ch_p(',') >> ast_p(1, int_p())) >> ch_p(']'));
+        std::string_view stream("[1,2]");
+        CHECK(group(stream));
+        CHECK(children(builder.root()) == Nodes({{2, "[1,2]"}}));
+        CHECK(children(*builder.root().first_child) == Nodes({{1, "1"}, {1, "2"}}));
+        builder.reset();
+    }
+
+    // the node of an alternative that failed after matching is dropped
+    {
+        const Parser<bool> choice = (ast_p(1, int_p()) >> ch_p(';')) | (ast_p(2, int_p()) >> ch_p('.'));
+        std::string_view stream("7.");
+        CHECK(choice(stream));
+        CHECK(children(builder.root()) == Nodes({{2, "7"}}));
+        builder.reset();
+    }
+
+    // a trailing repetition that backtracked leaves a top-level node only finish() can prune
+    {
+        const Parser<bool> items = *(ast_p(1, int_p()) >> ch_p(','));
+        std::string_view stream("1,2");
+        CHECK(items(stream));
+        CHECK(stream == "2");
+        builder.finish(stream);
+        CHECK(children(builder.root()) == Nodes({{1, "1"}}));
+        builder.reset();
+    }
+
+    // Arena: rewind reuses the memory, reset keeps the blocks
+    {
+        Arena arena(64);
+        const Arena::Mark mark = arena.mark();
+        int *first = arena.make<int>(1);
+        arena.rewind(mark);
+        int *second = arena.make<int>(2);
+        CHECK(first == second && *second == 2);
+        for (int i = 0; i < 100; ++i)
+        {
+            arena.make<long long>(i);
+        }
+        const size_t capacity = arena.capacity();
+        CHECK(capacity >= 100 * sizeof(long long));
+        arena.reset();
+        for (int i = 0; i < 100; ++i)
+        {
+            arena.make<long long>(i);
+        }
+        CHECK(arena.capacity() == capacity);
+    }
+    return check_result();
+}
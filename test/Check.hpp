@@ -0,0 +1,29 @@
+#pragma once
+#include <iostream>
+
+
+// Minimal assertions for the check programs registered with add_test.
+// A failed CHECK prints its line and condition and the program exits with 1 from
+// check_result(), so ctest reports it; the remaining checks still run.
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+inline int &check_failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+inline void check(const bool passed, const char *condition, const int line)
+{
+    if (!passed)
+    {
+        std::cerr << "line " << line << ": check failed: " << condition << std::endl;
+        ++check_failures();
+    }
+}
+
+inline int check_result()
+{
+    return check_failures() == 0 ? 0 : 1;
+}
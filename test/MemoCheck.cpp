@@ -0,0 +1,88 @@
+#include <string>
+#include <vector>
+#include "../Parser/ParserGen2.hpp"
+#include "../Parser/Memo.hpp"
+#include "../Parser/StreamParser.hpp"
+#include "Check.hpp"
+
+
+// Memo hits within a session, clear(), and no stale results once a buffer is reused.
+
+static size_t calls = 0;
+
+// +alpha_p() that counts how often it really runs
+static Parser<std::string> counted_word()
+{
+    const Parser<std::string> word = +alpha_p();
+    return Parser<std::string>(std::function<std::optional<std::string>(std::string_view &)>(
+        [=](std::string_view &stream)
+        {
+            ++calls;
+            return word(stream);
+        }));
+}
+
+int main()
+{
+    Memo memo;
+    const Parser<std::string> word = memo(counted_word());
+
+    // a second parse at the same position is answered from the cache
+    {
+        std::string input = "abc;";
+        const Memo::Session session(input);
+        calls = 0;
+        std::string_view first(input), second(input);
+        CHECK(word(first) == std::optional<std::string>("abc"));
+        CHECK(word(second) == std::optional<std::string>("abc"));
+        CHECK(second == ";");
+        CHECK(calls == 1);
+
+        // clear() forgets the results of the running session too
+        memo.clear();
+        std::string_view third(input);
+        CHECK(word(third) == std::optional<std::string>("abc"));
+        CHECK(calls == 2);
+
+        // failures are cached as well
+        std::string_view fourth(input.data() + 3, 1);
+        CHECK(!word(fourth).has_value());
+        CHECK(!word(fourth).has_value());
+        CHECK(calls == 3);
+    }
+
+    // the same buffer with new contents in a new session is parsed again
+    {
+        std::string input = "abc;";
+        {
+            const Memo::Session session(input);
+            std::string_view stream(input);
+            CHECK(word(stream) == std::optional<std::string>("abc"));
+        }
+        input.replace(0, 3, "xyz");
+        const Memo::Session session(input);
+        std::string_view stream(input);
+        CHECK(word(stream) == std::optional<std::string>("xyz"));
+    }
+
+    // without a session the rule runs every time
+    {
+        calls = 0;
+        std::string_view first("abc"), second("abc");
+        word(first);
+        word(second);
+        CHECK(calls == 2);
+    }
+
+    // StreamParser compacts its buffer in place, every feed() is a new session
+    {
+        std::vector<std::string> records;
+        StreamParser<std::string> parser(';', memo(+alpha_p()) >> ch_p(';'),
+            [&](std::string &&record) { records.push_back(record); });
+        parser.feed("ab;");
+        parser.feed("cd;");
+        CHECK(parser.finish() == StreamStatus::DONE);
+        CHECK(records == std::vector<std::string>({"ab;", "cd;"}));
+    }
+    return check_result();
+}
@@ -0,0 +1,75 @@
+#include <string>
+#include <vector>
+#include "../Parser/ParserGen2.hpp"
+#include "../Parser/StreamParser.hpp"
+#include "Check.hpp"
+
+
+// Records split across chunks at every byte, with and without a delimiter.
+
+static const std::string input = "12;345;6;7890;";
+
+static const std::vector<std::string> expected = {"12;", "345;", "6;", "7890;"};
+
+int main()
+{
+    const Parser<std::string> record = +alnum_p() >> ch_p(';');
+
+    // the input in two chunks, split at every position
+    for (size_t split = 0; split <= input.length(); ++split)
+    {
+        std::vector<std::string> records;
+        StreamParser<std::string> parser(';', record, [&](std::string &&value) { records.push_back(value); });
+        CHECK(parser.feed(std::string_view(input).substr(0, split)) == StreamStatus::NEED_MORE);
+        CHECK(parser.feed(std::string_view(input).substr(split)) == StreamStatus::NEED_MORE);
+        CHECK(parser.finish() == StreamStatus::DONE);
+        CHECK(records == expected);
+        CHECK(parser.count() == expected.size());
+        CHECK(parser.consumed() == input.length());
+    }
+
+    // one byte at a time; actions run once per record since only complete records are parsed
+    {
+        size_t actions = 0;
+        Parser<std::string> counted = record;
+        counted[std::function<void(void)>([&]() { ++actions; })];
+        StreamParser<std::string> parser(';', counted, [](std::string &&) {});
+        for (const char ch : input)
+        {
+            parser.feed(std::string_view(&ch, 1));
+        }
+        CHECK(parser.finish() == StreamStatus::DONE);
+        CHECK(actions == expected.size());
+    }
+
+    // without a delimiter, a record touching the end of the buffer waits for more input
+    {
+        std::vector<std::string> records;
+        StreamParser<std::string> parser(record, [&](std::string &&value) { records.push_back(value); });
+        for (const char ch : input)
+        {
+            CHECK(parser.feed(std::string_view(&ch, 1)) == StreamStatus::NEED_MORE);
+        }
+        CHECK(parser.finish() == StreamStatus::DONE);
+        CHECK(records == expected);
+    }
+
+    // an unfinished record fails at the end of input
+    {
+        StreamParser<std::string> parser(';', record, [](std::string &&) {});
+        parser.feed("12;34");
+        CHECK(parser.finish() == StreamStatus::FAILED);
+        CHECK(parser.count() == 1);
+        CHECK(parser.pending() == "34");
+    }
+
+    // a record that fails past a cut short of the end is reported at once
+    {
+        std::vector<std::string> records;
+        StreamParser<std::string_view> parser(raw_p(str_p("k") >> cut_p() >> +alnum_p() >> ch_p(';')),
+            [&](std::string_view &&value) { records.emplace_back(value); });
+        CHECK(parser.feed("k1;k!;k2") == StreamStatus::FAILED);
+        CHECK(records == std::vector<std::string>({"k1;"}));
+    }
+    return check_result();
+}